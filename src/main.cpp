@@ -2,9 +2,11 @@
 #include <libayatana-appindicator/app-indicator.h>
 #include <pulse/pulseaudio.h>
 #include <pulse/glib-mainloop.h>
+#include <pulse/thread-mainloop.h>
 #include <libsoup-3.0/libsoup/soup.h>
 #include <json-glib/json-glib.h>
 #include <keybinder.h>
+#include <sndfile.h>
 extern "C" {
 #include <xdo.h>
 }
@@ -17,761 +19,5057 @@ extern "C" {
 #include <algorithm>
 #include <ctime>
 #include <cstring>
+#include <cerrno>
+#include <climits>
+#include <memory>
+#include <map>
+#include <array>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/uinput.h>
+#include <numeric>
+#include <atomic>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 static constexpr int SAMPLE_RATE = 44100;
 static constexpr int NUM_CHANNELS = 1;
 static constexpr int BITS_PER_SAMPLE = 16;
 static constexpr double DECAY_FACTOR = 0.85;
+static constexpr int DEFAULT_UPLOAD_PARALLELISM = 3;
+static constexpr int MAX_UPLOAD_PARALLELISM = 8;
+static constexpr int DEFAULT_CONNECTION_KEEPALIVE = 60;  // seconds, 0 = off
+static constexpr int MAX_CONNECTION_KEEPALIVE = 600;
 static constexpr int WS_SAMPLE_RATE = 16000;
+static constexpr int DEFAULT_DICTATION_FRAME_MS = 50;  // realtime uplink
+static constexpr int DEFAULT_LIVE_FRAME_MS = 200;
 
-enum class TypingTool { NONE, XDO, WTYPE, YDOTOOL, XDOTOOL };
+enum class TypingTool { NONE, XDO, WTYPE, YDOTOOLD, UINPUT, YDOTOOL, XDOTOOL };
 
-struct VoiceNote {
-    std::string filepath;
-    std::string display_name;
-    double duration_seconds;
-    std::string transcription;
-    bool transcribing = false;
-    std::string diarized_transcription;
-    bool diarizing = false;
+// One backend's outcome from the typing probe
+struct TypingProbeResult {
+    TypingTool tool;
+    const char *name;
+    bool ok;
+    double elapsed_ms;
 };
 
-struct AppState {
-    GtkWidget *window = nullptr;
-    GtkWidget *label = nullptr;
-    GtkWidget *record_button = nullptr;
-    GtkWidget *level_bar = nullptr;
+// --- Audio resampler ---
 
-    // Save/Discard UI
-    GtkWidget *save_discard_box = nullptr;
-    GtkWidget *save_button = nullptr;
-    GtkWidget *discard_button = nullptr;
+// Streaming polyphase windowed-sinc resampler for any integer rate pair.
+// The prototype low-pass is cut just below the lower of the two Nyquist
+// frequencies so downsampling doesn't alias.  Filter history is carried
+// across chunks, so PulseAudio fragment boundaries are inaudible.
 
-    // Notes list UI
-    GtkWidget *notes_list_box = nullptr;
-    GtkWidget *notes_scroll = nullptr;
+static constexpr int RESAMPLER_ZERO_CROSSINGS = 16;
+static constexpr double RESAMPLER_KAISER_BETA = 8.0;
+static constexpr double RESAMPLER_ROLLOFF = 0.91;
 
-    // PulseAudio recording
-    pa_glib_mainloop *pa_ml = nullptr;
-    pa_context *pa_ctx = nullptr;
-    pa_stream *stream = nullptr;
+using DotKernel = float (*)(const float *, const float *, size_t);
 
-    // PulseAudio playback
-    pa_stream *playback_stream = nullptr;
-    bool playing = false;
-    std::vector<int16_t> playback_buffer;
-    size_t playback_offset = 0;
-    int playing_note_index = -1;
+static float dot_scalar(const float *a, const float *b, size_t n) {
+    float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < n; i += 4) {
+        acc[0] += a[i] * b[i];
+        acc[1] += a[i + 1] * b[i + 1];
+        acc[2] += a[i + 2] * b[i + 2];
+        acc[3] += a[i + 3] * b[i + 3];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
 
-    bool recording = false;
-    bool pa_ready = false;
-    double current_level = 0.0;
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse4.1")))
+static float dot_sse41(const float *a, const float *b, size_t n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (size_t i = 0; i < n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i),
+                                           _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4),
+                                           _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    return _mm_cvtss_f32(_mm_dp_ps(acc, _mm_set1_ps(1.0f), 0xF1));
+}
 
-    std::vector<int16_t> audio_buffer;
+__attribute__((target("avx2,fma")))
+static float dot_avx2(const float *a, const float *b, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t i = 0; i < n; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                              acc);
+    }
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc),
+                            _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+#endif
 
-    // Notes data
-    std::vector<VoiceNote> notes;
-    std::string data_dir;
+// Pick the widest dot-product kernel this CPU supports (resolved once)
+static DotKernel select_dot_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return dot_avx2;
+    if (__builtin_cpu_supports("sse4.1")) return dot_sse41;
+#endif
+    return dot_scalar;
+}
 
-    // Transcription service
-    SoupSession *soup_session = nullptr;
-    std::string api_key;
-    bool transcription_available = false;
+struct Resampler {
+    uint32_t up = 1;    // L: output rate / gcd
+    uint32_t down = 1;  // M: input rate / gcd
+    size_t taps = 0;    // taps per phase, padded to a multiple of 8
+    std::vector<float> coeffs;  // up × taps, one contiguous row per phase
+    std::vector<float> history; // unconsumed input, converted to float
+    size_t read_pos = 0;        // window start for the next output
+    uint32_t phase = 0;         // next output's sub-sample phase (0..up-1)
+    DotKernel dot = nullptr;
+};
 
-    // Real-time transcription (WebSocket)
-    SoupWebsocketConnection *ws_conn = nullptr;
-    bool ws_ready = false;
-    std::string live_transcription;
-    GtkWidget *live_transcription_scroll = nullptr;
-    GtkWidget *live_transcription_view = nullptr;
-    std::string live_transcription_tmp_path;
+static void resampler_reset(Resampler *rs) {
+    // Pre-fill half a window of silence so output 0 is centred on input 0
+    rs->history.assign(rs->taps / 2 - 1, 0.0f);
+    rs->read_pos = 0;
+    rs->phase = 0;
+}
 
-    // Resampler state (44100→16000, preserved between PulseAudio chunks)
-    double resample_phase = 0.0;
+static void resampler_init(Resampler *rs, uint32_t in_rate,
+                           uint32_t out_rate) {
+    uint32_t g = std::gcd(in_rate, out_rate);
+    rs->up = out_rate / g;
+    rs->down = in_rate / g;
+
+    // Cutoff relative to the input Nyquist frequency
+    double cutoff = RESAMPLER_ROLLOFF *
+                    std::min(1.0, static_cast<double>(out_rate) / in_rate);
+    auto taps = static_cast<size_t>(
+        std::ceil(2.0 * RESAMPLER_ZERO_CROSSINGS / cutoff));
+    rs->taps = (taps + 7) & ~static_cast<size_t>(7);
+
+    double half = static_cast<double>(rs->taps) / 2.0;
+    double norm = std::cyl_bessel_i(0.0, RESAMPLER_KAISER_BETA);
+    rs->coeffs.assign(rs->up * rs->taps, 0.0f);
+    for (uint32_t p = 0; p < rs->up; p++) {
+        float *row = rs->coeffs.data() + p * rs->taps;
+        double frac = static_cast<double>(p) / rs->up;
+        double sum = 0.0;
+        std::vector<double> h(rs->taps);
+        for (size_t j = 0; j < rs->taps; j++) {
+            // Distance in input samples from this tap to the output instant
+            double t = frac + (half - 1.0) - static_cast<double>(j);
+            double x = cutoff * t;
+            double sinc = (std::fabs(x) < 1e-9)
+                              ? 1.0
+                              : std::sin(M_PI * x) / (M_PI * x);
+            double r = t / half;
+            double win = (std::fabs(r) >= 1.0)
+                             ? 0.0
+                             : std::cyl_bessel_i(
+                                   0.0, RESAMPLER_KAISER_BETA *
+                                            std::sqrt(1.0 - r * r)) /
+                                   norm;
+            h[j] = sinc * win;
+            sum += h[j];
+        }
+        // Unity DC gain per phase
+        for (size_t j = 0; j < rs->taps; j++) {
+            row[j] = static_cast<float>(h[j] / sum);
+        }
+    }
 
-    // Dictation mode
-    bool dictating = false;
-    xdo_t *xdo = nullptr;
-    TypingTool typing_tool = TypingTool::NONE;
-    std::string dictation_buffer;
-    guint dictation_flush_id = 0;
-    AppIndicator *indicator = nullptr;
-    std::string hotkey;
-    GtkWidget *dictation_menu_item = nullptr;
+    static const DotKernel kernel = select_dot_kernel();
+    rs->dot = kernel;
+    resampler_reset(rs);
+}
 
-    // Audio device selection
-    std::vector<std::pair<std::string, std::string>> audio_sources;  // (pa_name, description)
-    std::string audio_device;  // selected device pa_name, empty = default
-};
+// Upper bound on outputs produced by feeding `count` more input samples
+static size_t resampler_max_output(const Resampler *rs, size_t count) {
+    return (count * rs->up) / rs->down + 2;
+}
 
-// Forward declarations
-static void stop_playback(AppState *state);
-static void refresh_notes_list(AppState *state);
-static void load_notes(AppState *state);
-static void transcribe_note(AppState *state, int note_index);
-static void ws_connect(AppState *state);
-static void ws_disconnect(AppState *state);
-static void ws_send_audio(AppState *state, const int16_t *samples, size_t count);
-static void start_dictation(AppState *state);
-static void stop_dictation(AppState *state);
-static void update_dictation_menu_label(AppState *state);
-static void type_text(AppState *state, const char *text);
-static void diarize_note(AppState *state, int note_index);
+// Resample `count` samples into `out` (capacity `out_cap`), returning how
+// many were written.  Input that can't be consumed yet stays in history.
+static size_t resampler_process(Resampler *rs, const int16_t *in,
+                                size_t count, int16_t *out, size_t out_cap) {
+    rs->history.reserve(rs->history.size() + count);
+    for (size_t i = 0; i < count; i++) {
+        rs->history.push_back(static_cast<float>(in[i]));
+    }
 
-struct TranscribeCallbackData {
-    AppState *state;
-    int note_index;
-};
+    const float *buf = rs->history.data();
+    size_t avail = rs->history.size();
+    size_t produced = 0;
+    while (produced < out_cap && rs->read_pos + rs->taps <= avail) {
+        float y = rs->dot(buf + rs->read_pos,
+                          rs->coeffs.data() + rs->phase * rs->taps, rs->taps);
+        y = std::clamp(y, -32768.0f, 32767.0f);
+        out[produced++] = static_cast<int16_t>(std::lrint(y));
+
+        rs->phase += rs->down;
+        rs->read_pos += rs->phase / rs->up;
+        rs->phase %= rs->up;
+    }
 
-struct DiarizeCallbackData {
-    AppState *state;
-    int note_index;
+    // Drop consumed samples, keep the tail as history for the next chunk
+    size_t keep_from = std::min(rs->read_pos, avail);
+    rs->history.erase(rs->history.begin(),
+                      rs->history.begin() +
+                          static_cast<std::ptrdiff_t>(keep_from));
+    rs->read_pos -= keep_from;
+    return produced;
+}
+
+// --- Lock-free capture ring ---
+
+// Single-producer/single-consumer sample ring.  The PulseAudio capture
+// thread pushes and the GTK main loop drains; neither side ever blocks.
+struct SpscRing {
+    std::vector<int16_t> buf;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0};  // advanced by the producer
+    alignas(64) std::atomic<size_t> tail{0};  // advanced by the consumer
+    std::atomic<uint64_t> dropped{0};         // samples lost to overflow
 };
 
-// --- Storage helpers ---
+// Only call while no producer or consumer is attached
+static void ring_init(SpscRing *ring, size_t min_capacity) {
+    size_t cap = 1;
+    while (cap < min_capacity) cap <<= 1;
+    ring->buf.assign(cap, 0);
+    ring->mask = cap - 1;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->dropped.store(0, std::memory_order_relaxed);
+}
 
-static void ensure_data_dir(AppState *state) {
-    const char *data_base = g_get_user_data_dir();
-    state->data_dir = std::string(data_base) + "/linscribe";
-    std::filesystem::create_directories(state->data_dir);
+// Producer side — copies as much as fits and counts the rest as dropped
+static size_t ring_push(SpscRing *ring, const int16_t *data, size_t count) {
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    size_t tail = ring->tail.load(std::memory_order_acquire);
+    size_t n = std::min(count, ring->buf.size() - (head - tail));
+
+    size_t start = head & ring->mask;
+    size_t first = std::min(n, ring->buf.size() - start);
+    std::memcpy(ring->buf.data() + start, data, first * sizeof(int16_t));
+    std::memcpy(ring->buf.data(), data + first, (n - first) * sizeof(int16_t));
+    ring->head.store(head + n, std::memory_order_release);
+
+    if (n < count) {
+        ring->dropped.fetch_add(count - n, std::memory_order_relaxed);
+    }
+    return n;
 }
 
-static bool write_wav_file(const std::string &path,
-                           const std::vector<int16_t> &samples) {
-    std::ofstream out(path, std::ios::binary);
-    if (!out) return false;
+// Consumer side — returns the number of samples copied into `out`
+static size_t ring_pop(SpscRing *ring, int16_t *out, size_t max) {
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    size_t head = ring->head.load(std::memory_order_acquire);
+    size_t n = std::min(max, head - tail);
+
+    size_t start = tail & ring->mask;
+    size_t first = std::min(n, ring->buf.size() - start);
+    std::memcpy(out, ring->buf.data() + start, first * sizeof(int16_t));
+    std::memcpy(out + first, ring->buf.data(), (n - first) * sizeof(int16_t));
+    ring->tail.store(tail + n, std::memory_order_release);
+    return n;
+}
 
-    uint32_t data_size = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
-    uint32_t file_size = 36 + data_size;
-    uint16_t block_align = NUM_CHANNELS * BITS_PER_SAMPLE / 8;
-    uint32_t byte_rate = SAMPLE_RATE * block_align;
+// --- Chunked audio store ---
 
-    // RIFF header
-    out.write("RIFF", 4);
-    out.write(reinterpret_cast<const char *>(&file_size), 4);
-    out.write("WAVE", 4);
+// Audio is held in fixed-size blocks carved out of larger slabs, so
+// appending never reallocates or copies what's already stored, and
+// memory grows one slab at a time instead of doubling.
+static constexpr size_t AUDIO_BLOCK_SAMPLES = 16384;  // 32 KiB
+static constexpr size_t AUDIO_SLAB_BLOCKS = 32;       // 1 MiB per slab
 
-    // fmt chunk
-    out.write("fmt ", 4);
-    uint32_t fmt_size = 16;
-    out.write(reinterpret_cast<const char *>(&fmt_size), 4);
-    uint16_t audio_format = 1; // PCM
-    out.write(reinterpret_cast<const char *>(&audio_format), 2);
-    uint16_t channels = NUM_CHANNELS;
-    out.write(reinterpret_cast<const char *>(&channels), 2);
-    uint32_t sample_rate = SAMPLE_RATE;
-    out.write(reinterpret_cast<const char *>(&sample_rate), 4);
-    out.write(reinterpret_cast<const char *>(&byte_rate), 4);
-    out.write(reinterpret_cast<const char *>(&block_align), 2);
-    uint16_t bits = BITS_PER_SAMPLE;
-    out.write(reinterpret_cast<const char *>(&bits), 2);
+struct AudioChunkStore {
+    std::vector<std::unique_ptr<int16_t[]>> slabs;
+    std::vector<int16_t *> free_blocks;  // pooled, ready for reuse
+    std::vector<int16_t *> blocks;       // in use, in order
+    size_t size = 0;                     // samples stored
+    std::vector<struct iovec> iov;       // scratch for audio_store_writev
+};
 
-    // data chunk
-    out.write("data", 4);
-    out.write(reinterpret_cast<const char *>(&data_size), 4);
-    out.write(reinterpret_cast<const char *>(samples.data()),
-              static_cast<std::streamsize>(data_size));
+static int16_t *audio_store_acquire_block(AudioChunkStore *store) {
+    if (store->free_blocks.empty()) {
+        store->slabs.emplace_back(
+            new int16_t[AUDIO_BLOCK_SAMPLES * AUDIO_SLAB_BLOCKS]);
+        int16_t *slab = store->slabs.back().get();
+        for (size_t i = AUDIO_SLAB_BLOCKS; i-- > 0;) {
+            store->free_blocks.push_back(slab + i * AUDIO_BLOCK_SAMPLES);
+        }
+    }
+    int16_t *block = store->free_blocks.back();
+    store->free_blocks.pop_back();
+    return block;
+}
 
-    return out.good();
+static void audio_store_append(AudioChunkStore *store, const int16_t *samples,
+                               size_t count) {
+    while (count > 0) {
+        size_t used = store->size % AUDIO_BLOCK_SAMPLES;
+        if (used == 0) {
+            store->blocks.push_back(audio_store_acquire_block(store));
+        }
+        size_t n = std::min(count, AUDIO_BLOCK_SAMPLES - used);
+        std::memcpy(store->blocks.back() + used, samples,
+                    n * sizeof(int16_t));
+        store->size += n;
+        samples += n;
+        count -= n;
+    }
 }
 
-static bool read_wav_file(const std::string &path,
-                          std::vector<int16_t> &samples) {
-    std::ifstream in(path, std::ios::binary);
-    if (!in) return false;
+// Contiguous run of samples at block `index`; `len` receives its length
+static const int16_t *audio_store_block(const AudioChunkStore *store,
+                                        size_t index, size_t *len) {
+    size_t start = index * AUDIO_BLOCK_SAMPLES;
+    *len = std::min(AUDIO_BLOCK_SAMPLES, store->size - start);
+    return store->blocks[index];
+}
 
-    char riff[4], wave[4], fmt_id[4], data_id[4];
-    uint32_t file_size, fmt_size, data_size;
-    uint16_t audio_format, channels, bits_per_sample, block_align;
-    uint32_t sample_rate, byte_rate;
+// Empty the store, keeping its blocks pooled for the next append
+static void audio_store_clear(AudioChunkStore *store) {
+    store->free_blocks.insert(store->free_blocks.end(),
+                              store->blocks.rbegin(), store->blocks.rend());
+    store->blocks.clear();
+    store->size = 0;
+}
 
-    in.read(riff, 4);
-    in.read(reinterpret_cast<char *>(&file_size), 4);
-    in.read(wave, 4);
+// Scatter-gather write of the whole store to `fd`
+static bool audio_store_writev(AudioChunkStore *store, int fd) {
+    store->iov.clear();
+    for (size_t i = 0; i < store->blocks.size(); i++) {
+        size_t len;
+        const int16_t *data = audio_store_block(store, i, &len);
+        store->iov.push_back({const_cast<int16_t *>(data),
+                              len * sizeof(int16_t)});
+    }
 
-    if (std::memcmp(riff, "RIFF", 4) != 0 ||
-        std::memcmp(wave, "WAVE", 4) != 0)
-        return false;
+    struct iovec *iov = store->iov.data();
+    size_t iovcnt = store->iov.size();
+    while (iovcnt > 0) {
+        ssize_t n = ::writev(fd, iov,
+                             static_cast<int>(std::min<size_t>(iovcnt, IOV_MAX)));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        // Skip fully written vectors and trim a partially written one
+        auto left = static_cast<size_t>(n);
+        while (iovcnt > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + left;
+            iov->iov_len -= left;
+        }
+    }
+    return true;
+}
 
-    in.read(fmt_id, 4);
-    in.read(reinterpret_cast<char *>(&fmt_size), 4);
-    if (std::memcmp(fmt_id, "fmt ", 4) != 0) return false;
+// --- WAV files ---
+
+// Streaming WAV layout: a 28-byte JUNK chunk after the RIFF header
+// reserves room for an RF64 ds64 chunk, so a recording that grows past
+// 4 GiB can be promoted in place when the header is patched on stop.
+static constexpr size_t WAV_HEADER_SIZE = 80;
+static constexpr size_t WAV_DS64_OFFSET = 12;
+static constexpr size_t WAV_DATA_SIZE_OFFSET = 76;
+
+// Append-only WAV file whose header is patched once recording stops
+struct WavWriter {
+    int fd = -1;
+    std::string path;
+    uint32_t sample_rate = 0;
+    uint64_t data_bytes = 0;
+};
+
+static void put_le16(unsigned char *p, uint16_t v) {
+    p[0] = static_cast<unsigned char>(v);
+    p[1] = static_cast<unsigned char>(v >> 8);
+}
+
+static void put_le32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
 
-    in.read(reinterpret_cast<char *>(&audio_format), 2);
-    in.read(reinterpret_cast<char *>(&channels), 2);
-    in.read(reinterpret_cast<char *>(&sample_rate), 4);
-    in.read(reinterpret_cast<char *>(&byte_rate), 4);
-    in.read(reinterpret_cast<char *>(&block_align), 2);
-    in.read(reinterpret_cast<char *>(&bits_per_sample), 2);
+static void put_le64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
 
-    // Skip any extra fmt bytes
-    if (fmt_size > 16) {
-        in.seekg(static_cast<std::streamoff>(fmt_size - 16),
-                 std::ios::cur);
+// Build the 80-byte header for `data_bytes` of mono S16LE at `sample_rate`,
+// as RIFF when it fits in 32-bit sizes and RF64 otherwise
+static void build_wav_header(unsigned char *h, uint32_t sample_rate,
+                             uint64_t data_bytes) {
+    uint16_t block_align = NUM_CHANNELS * BITS_PER_SAMPLE / 8;
+    uint64_t riff_size = WAV_HEADER_SIZE - 8 + data_bytes;
+    bool rf64 = riff_size > UINT32_MAX;
+
+    std::memset(h, 0, WAV_HEADER_SIZE);
+    std::memcpy(h, rf64 ? "RF64" : "RIFF", 4);
+    put_le32(h + 4, rf64 ? UINT32_MAX : static_cast<uint32_t>(riff_size));
+    std::memcpy(h + 8, "WAVE", 4);
+
+    // ds64 (or JUNK placeholder): riff size, data size, sample count, table
+    std::memcpy(h + WAV_DS64_OFFSET, rf64 ? "ds64" : "JUNK", 4);
+    put_le32(h + 16, 28);
+    if (rf64) {
+        put_le64(h + 20, riff_size);
+        put_le64(h + 28, data_bytes);
+        put_le64(h + 36, data_bytes / block_align);
     }
 
-    in.read(data_id, 4);
-    in.read(reinterpret_cast<char *>(&data_size), 4);
-    if (std::memcmp(data_id, "data", 4) != 0) return false;
+    // fmt chunk
+    std::memcpy(h + 48, "fmt ", 4);
+    put_le32(h + 52, 16);
+    put_le16(h + 56, 1); // PCM
+    put_le16(h + 58, NUM_CHANNELS);
+    put_le32(h + 60, sample_rate);
+    put_le32(h + 64, sample_rate * block_align);
+    put_le16(h + 68, block_align);
+    put_le16(h + 70, BITS_PER_SAMPLE);
 
-    size_t num_samples = data_size / sizeof(int16_t);
-    samples.resize(num_samples);
-    in.read(reinterpret_cast<char *>(samples.data()),
-            static_cast<std::streamsize>(data_size));
+    // data chunk
+    std::memcpy(h + 72, "data", 4);
+    put_le32(h + WAV_DATA_SIZE_OFFSET,
+             rf64 ? UINT32_MAX : static_cast<uint32_t>(data_bytes));
+}
 
-    return in.good();
+static bool write_all(int fd, const void *buf, size_t len) {
+    auto *p = static_cast<const char *>(buf);
+    while (len > 0) {
+        ssize_t n = ::write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
 }
 
-static double get_wav_duration(const std::string &path) {
-    std::ifstream in(path, std::ios::binary);
-    if (!in) return 0.0;
+static bool wav_writer_open(WavWriter *w, const std::string &path,
+                            uint32_t sample_rate) {
+    w->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   0644);
+    if (w->fd < 0) return false;
+    w->path = path;
+    w->sample_rate = sample_rate;
+    w->data_bytes = 0;
+
+    unsigned char header[WAV_HEADER_SIZE];
+    build_wav_header(header, sample_rate, 0);
+    if (!write_all(w->fd, header, sizeof(header))) {
+        ::close(w->fd);
+        w->fd = -1;
+        return false;
+    }
+    return true;
+}
 
-    // Skip to byte 24 for sample rate, then to byte 40 for data size
-    char header[44];
-    in.read(header, 44);
-    if (!in.good()) return 0.0;
+// Write out everything buffered in `store` and empty it for reuse
+static bool wav_writer_flush(WavWriter *w, AudioChunkStore *store) {
+    if (w->fd < 0) return false;
+    if (store->size == 0) return true;
+    bool ok = audio_store_writev(store, w->fd);
+    if (ok) {
+        w->data_bytes += store->size * sizeof(int16_t);
+    } else {
+        // Drop whatever part of the batch did land, so the file stays
+        // sample-aligned and in step with data_bytes for later flushes
+        int err = errno;
+        auto end = static_cast<off_t>(WAV_HEADER_SIZE + w->data_bytes);
+        if (::ftruncate(w->fd, end) != 0) {
+            g_warning("Failed to trim partial write from %s",
+                      w->path.c_str());
+        }
+        ::lseek(w->fd, end, SEEK_SET);
+        errno = err;
+    }
+    audio_store_clear(store);
+    return ok;
+}
 
-    uint32_t sample_rate;
-    uint16_t channels, bits_per_sample;
-    uint32_t data_size;
+// Patch the final sizes into the header and close the file
+static bool wav_writer_finish(WavWriter *w) {
+    if (w->fd < 0) return false;
+    unsigned char header[WAV_HEADER_SIZE];
+    build_wav_header(header, w->sample_rate, w->data_bytes);
+    bool ok = ::pwrite(w->fd, header, sizeof(header), 0) ==
+              static_cast<ssize_t>(sizeof(header));
+    ok = (::close(w->fd) == 0) && ok;
+    w->fd = -1;
+    return ok;
+}
 
-    std::memcpy(&sample_rate, header + 24, 4);
-    std::memcpy(&channels, header + 22, 2);
-    std::memcpy(&bits_per_sample, header + 34, 2);
-    std::memcpy(&data_size, header + 40, 4);
+// Close (if still open) and delete the file
+static void wav_writer_discard(WavWriter *w) {
+    if (w->fd >= 0) {
+        ::close(w->fd);
+        w->fd = -1;
+    }
+    if (!w->path.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(w->path, ec);
+    }
+    w->path.clear();
+    w->data_bytes = 0;
+}
 
-    if (sample_rate == 0 || channels == 0 || bits_per_sample == 0)
-        return 0.0;
+// Repair the header of a WAV whose writer never got to patch it (crash)
+static bool wav_repair_header(const std::string &path, uint32_t sample_rate) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec || size <= WAV_HEADER_SIZE) return false;
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    uint64_t data_bytes = (size - WAV_HEADER_SIZE) & ~static_cast<uint64_t>(1);
+    unsigned char header[WAV_HEADER_SIZE];
+    build_wav_header(header, sample_rate, data_bytes);
+    bool ok = ::pwrite(fd, header, sizeof(header), 0) ==
+              static_cast<ssize_t>(sizeof(header));
+    ok = (::close(fd) == 0) && ok;
+    return ok;
+}
 
-    uint32_t bytes_per_sample = channels * bits_per_sample / 8;
-    if (bytes_per_sample == 0) return 0.0;
+// --- Transcript journal ---
+
+// The live transcript is journaled while recording so a crash loses at
+// most a second or so of it.  One fd stays open; deltas are framed as
+// records and handed to a writer thread, which appends them in batches
+// and fdatasync()s once DEFAULT_JOURNAL_SYNC_MS has passed since the
+// oldest unwritten record, or sooner when DEFAULT_JOURNAL_SYNC_BYTES have
+// built up.  Both bounds are set by the `journal_sync` file.
+//
+// Layout: "LSJ1", then records of a 24-byte little-endian header (text
+// length, checksum, transcript offset, wall-clock µs) followed by the
+// text.  The checksum is FNV-1a over the other header fields and the
+// text.  A torn record at the end is ignored on recovery.
+
+static constexpr char JOURNAL_MAGIC[4] = {'L', 'S', 'J', '1'};
+static constexpr size_t JOURNAL_RECORD_HEADER = 24;
+static constexpr int DEFAULT_JOURNAL_SYNC_MS = 1000;
+static constexpr int DEFAULT_JOURNAL_SYNC_BYTES = 4096;
+
+struct TranscriptJournal {
+    int fd = -1;
+    GThread *thread = nullptr;
+    GMutex lock;
+    GCond wake;
+    std::string pending;        // framed records not yet written
+    gint64 pending_since = 0;   // when the oldest of them was added
+    bool quit = false;
+    uint64_t offset = 0;        // transcript bytes journaled, main thread
+    int sync_ms = DEFAULT_JOURNAL_SYNC_MS;
+    size_t sync_bytes = DEFAULT_JOURNAL_SYNC_BYTES;
+    std::atomic<bool> failed{false};
+    uint64_t batches = 0;       // writer thread, read after join
+};
 
-    uint32_t total_samples = data_size / bytes_per_sample;
-    return static_cast<double>(total_samples) / static_cast<double>(sample_rate);
+static uint32_t get_le32(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
 }
 
-static std::string generate_note_filename(const std::string &data_dir) {
-    std::time_t now = std::time(nullptr);
-    std::tm *tm = std::localtime(&now);
-    char buf[64];
-    std::strftime(buf, sizeof(buf), "note_%Y-%m-%d_%H-%M-%S.wav", tm);
-    return data_dir + "/" + buf;
+static uint64_t get_le64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
 }
 
-static void load_notes(AppState *state) {
-    state->notes.clear();
-
-    if (!std::filesystem::exists(state->data_dir)) return;
+static uint32_t fnv1a(uint32_t h, const unsigned char *p, size_t len) {
+    for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
 
-    for (const auto &entry :
-         std::filesystem::directory_iterator(state->data_dir)) {
-        if (!entry.is_regular_file()) continue;
-        if (entry.path().extension() != ".wav") continue;
+// Everything in the record but the checksum field itself
+static uint32_t journal_check(const unsigned char *header, const char *text,
+                              size_t len) {
+    uint32_t h = fnv1a(2166136261u, header, 4);
+    h = fnv1a(h, header + 8, JOURNAL_RECORD_HEADER - 8);
+    return fnv1a(h, reinterpret_cast<const unsigned char *>(text), len);
+}
 
-        VoiceNote note;
-        note.filepath = entry.path().string();
-        // Extract display name from filename: note_YYYY-MM-DD_HH-MM-SS.wav
-        std::string stem = entry.path().stem().string();
-        if (stem.rfind("note_", 0) == 0 && stem.size() >= 24) {
-            // Convert note_YYYY-MM-DD_HH-MM-SS to YYYY-MM-DD HH:MM:SS
-            std::string date_part = stem.substr(5, 10);       // YYYY-MM-DD
-            std::string time_part = stem.substr(16, 8);       // HH-MM-SS
-            // Replace dashes with colons in time
-            for (auto &c : time_part) {
-                if (c == '-') c = ':';
-            }
-            note.display_name = date_part + " " + time_part;
-        } else {
-            note.display_name = stem;
+static gpointer journal_thread(gpointer userdata) {
+    auto *j = static_cast<TranscriptJournal *>(userdata);
+    std::string batch;
+    g_mutex_lock(&j->lock);
+    for (;;) {
+        while (!j->quit && j->pending.empty()) {
+            g_cond_wait(&j->wake, &j->lock);
         }
-        note.duration_seconds = get_wav_duration(note.filepath);
-
-        // Load transcription from .txt sidecar if it exists
-        std::filesystem::path txt_path = entry.path();
-        txt_path.replace_extension(".txt");
-        if (std::filesystem::exists(txt_path)) {
-            std::ifstream txt_file(txt_path);
-            if (txt_file) {
-                note.transcription = std::string(
-                    std::istreambuf_iterator<char>(txt_file),
-                    std::istreambuf_iterator<char>());
-            }
+        // Let records gather until the interval is up or enough is queued
+        gint64 deadline =
+            j->pending_since + j->sync_ms * G_TIME_SPAN_MILLISECOND;
+        while (!j->quit && j->pending.size() < j->sync_bytes &&
+               g_cond_wait_until(&j->wake, &j->lock, deadline)) {
         }
-
-        // Load diarized transcription from .diarized.txt sidecar if it exists
-        std::filesystem::path diarized_path(note.filepath);
-        diarized_path.replace_extension(".diarized.txt");
-        if (std::filesystem::exists(diarized_path)) {
-            std::ifstream diarized_file(diarized_path);
-            if (diarized_file) {
-                note.diarized_transcription = std::string(
-                    std::istreambuf_iterator<char>(diarized_file),
-                    std::istreambuf_iterator<char>());
+        bool quit = j->quit;
+        batch.swap(j->pending);
+        g_mutex_unlock(&j->lock);
+
+        if (!batch.empty()) {
+            bool ok = write_all(j->fd, batch.data(), batch.size()) &&
+                      ::fdatasync(j->fd) == 0;
+            if (!ok && !j->failed.exchange(true)) {
+                g_warning("Failed to write transcript journal: %s",
+                          g_strerror(errno));
             }
+            batch.clear();
+            j->batches++;
         }
 
-        state->notes.push_back(std::move(note));
+        g_mutex_lock(&j->lock);
+        if (quit && j->pending.empty()) break;
     }
+    g_mutex_unlock(&j->lock);
+    return nullptr;
+}
 
-    // Sort newest-first
-    std::sort(state->notes.begin(), state->notes.end(),
-              [](const VoiceNote &a, const VoiceNote &b) {
-                  return a.filepath > b.filepath;
-              });
+static bool journal_open(TranscriptJournal *j, const std::string &path,
+                         int sync_ms, int sync_bytes) {
+    j->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   0644);
+    if (j->fd < 0) return false;
+    if (!write_all(j->fd, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC))) {
+        ::close(j->fd);
+        j->fd = -1;
+        return false;
+    }
+    j->pending.clear();
+    j->quit = false;
+    j->offset = 0;
+    j->sync_ms = sync_ms;
+    j->sync_bytes = static_cast<size_t>(sync_bytes);
+    j->failed = false;
+    j->batches = 0;
+    g_mutex_init(&j->lock);
+    g_cond_init(&j->wake);
+    j->thread = g_thread_new("transcript-journal", journal_thread, j);
+    return true;
 }
 
-// --- Audio helpers ---
+// Queue one delta; it reaches the disk within the sync interval
+static void journal_append(TranscriptJournal *j, const std::string &text) {
+    if (j->fd < 0 || text.empty()) return;
+    unsigned char header[JOURNAL_RECORD_HEADER];
+    put_le32(header, static_cast<uint32_t>(text.size()));
+    put_le64(header + 8, j->offset);
+    put_le64(header + 16, static_cast<uint64_t>(g_get_real_time()));
+    put_le32(header + 4, journal_check(header, text.data(), text.size()));
+    j->offset += text.size();
+
+    g_mutex_lock(&j->lock);
+    bool was_empty = j->pending.empty();
+    if (was_empty) j->pending_since = g_get_monotonic_time();
+    j->pending.append(reinterpret_cast<const char *>(header), sizeof(header));
+    j->pending += text;
+    if (was_empty || j->pending.size() >= j->sync_bytes) {
+        g_cond_signal(&j->wake);
+    }
+    g_mutex_unlock(&j->lock);
+}
 
-static double calculate_peak_level(const int16_t *data, size_t num_samples) {
-    int16_t peak = 0;
-    for (size_t i = 0; i < num_samples; i++) {
-        auto abs_val = static_cast<int16_t>(std::abs(data[i]));
-        if (abs_val > peak) {
-            peak = abs_val;
-        }
+// Write out and sync what is queued, then close.  The file is left for
+// the caller to remove.
+static void journal_close(TranscriptJournal *j) {
+    if (j->thread == nullptr) return;
+    g_mutex_lock(&j->lock);
+    j->quit = true;
+    g_cond_signal(&j->wake);
+    g_mutex_unlock(&j->lock);
+    g_thread_join(j->thread);
+    j->thread = nullptr;
+    ::close(j->fd);
+    j->fd = -1;
+    g_mutex_clear(&j->lock);
+    g_cond_clear(&j->wake);
+    if (j->offset > 0) {
+        g_message("Transcript journal: %" G_GUINT64_FORMAT " bytes in %"
+                  G_GUINT64_FORMAT " synced batches", j->offset, j->batches);
     }
-    return static_cast<double>(peak) / 32768.0;
 }
 
-// --- PulseAudio playback ---
+// Read back the text of a journal left by a crash.  False if the file
+// isn't a journal at all.
+static bool journal_recover(const std::string &path, std::string *text,
+                            gint64 *last_time_us) {
+    std::ifstream in(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(JOURNAL_MAGIC) ||
+        std::memcmp(data.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)
+        return false;
 
-static void on_playback_drain_complete(pa_stream * /*s*/, int /*success*/,
-                                       void *userdata) {
-    auto *state = static_cast<AppState *>(userdata);
-    stop_playback(state);
+    text->clear();
+    *last_time_us = 0;
+    size_t pos = sizeof(JOURNAL_MAGIC);
+    while (data.size() - pos >= JOURNAL_RECORD_HEADER) {
+        auto *h = reinterpret_cast<const unsigned char *>(data.data() + pos);
+        size_t len = get_le32(h);
+        if (data.size() - pos - JOURNAL_RECORD_HEADER < len) break;
+        const char *record = data.data() + pos + JOURNAL_RECORD_HEADER;
+        if (get_le64(h + 8) != text->size() ||
+            get_le32(h + 4) != journal_check(h, record, len))
+            break;
+        text->append(record, len);
+        *last_time_us = static_cast<gint64>(get_le64(h + 16));
+        pos += JOURNAL_RECORD_HEADER + len;
+    }
+    if (pos < data.size()) {
+        g_message("Transcript journal ends in %zu bytes of a torn record",
+                  data.size() - pos);
+    }
+    return true;
 }
 
-static void on_playback_write(pa_stream *s, size_t nbytes, void *userdata) {
-    auto *state = static_cast<AppState *>(userdata);
+// --- Audio codecs ---
 
-    if (state->playback_offset >= state->playback_buffer.size()) {
-        pa_operation *op = pa_stream_drain(s, on_playback_drain_complete, state);
-        if (op != nullptr) pa_operation_unref(op);
-        return;
-    }
+// Notes are archived as WAV, FLAC or Opus.  Recording always streams to a
+// WAV first (cheap and crash-safe); a compressed copy is encoded from it
+// on a worker thread once the note is saved.  Reading goes through
+// libsndfile, which also understands our RF64 headers.
+
+enum class AudioCodec { WAV, FLAC, OPUS };
+
+struct CodecInfo {
+    AudioCodec codec;
+    const char *key;        // stored in the archive_format setting
+    const char *label;      // shown in Settings
+    const char *extension;
+    const char *mime_type;  // for uploads
+    int sf_format;
+    uint32_t sample_rate;   // 0 keeps the recording rate
+};
 
-    size_t remaining_samples =
-        state->playback_buffer.size() - state->playback_offset;
-    size_t max_samples = nbytes / sizeof(int16_t);
-    size_t to_write = std::min(remaining_samples, max_samples);
-    size_t bytes = to_write * sizeof(int16_t);
+static const CodecInfo AUDIO_CODECS[] = {
+    {AudioCodec::WAV, "wav", "WAV (uncompressed)", ".wav", "audio/wav",
+     SF_FORMAT_WAV | SF_FORMAT_PCM_16, 0},
+    {AudioCodec::FLAC, "flac", "FLAC (lossless)", ".flac", "audio/flac",
+     SF_FORMAT_FLAC | SF_FORMAT_PCM_16, 0},
+    // Opus only runs at 8, 12, 16, 24 or 48 kHz
+    {AudioCodec::OPUS, "opus", "Opus (smallest)", ".opus", "audio/ogg",
+     SF_FORMAT_OGG | SF_FORMAT_OPUS, 48000},
+};
+
+static constexpr size_t CODEC_CHUNK_FRAMES = 4096;
 
-    pa_stream_write(s,
-                    state->playback_buffer.data() + state->playback_offset,
-                    bytes, nullptr, 0, PA_SEEK_RELATIVE);
-    state->playback_offset += to_write;
+static const CodecInfo *codec_by_key(const std::string &key) {
+    for (const auto &c : AUDIO_CODECS) {
+        if (key == c.key) return &c;
+    }
+    return nullptr;
 }
 
-static void on_playback_stream_state(pa_stream *s, void *userdata) {
-    auto *state = static_cast<AppState *>(userdata);
-    if (pa_stream_get_state(s) == PA_STREAM_FAILED) {
-        g_warning("Playback stream failed: %s",
-                  pa_strerror(pa_context_errno(state->pa_ctx)));
-        stop_playback(state);
+static const CodecInfo *codec_info(AudioCodec codec) {
+    for (const auto &c : AUDIO_CODECS) {
+        if (c.codec == codec) return &c;
     }
+    return &AUDIO_CODECS[0];
 }
 
-static void start_playback(AppState *state, int note_index) {
-    if (note_index < 0 ||
-        note_index >= static_cast<int>(state->notes.size()))
-        return;
-    if (!state->pa_ready) return;
+static const CodecInfo *codec_for_path(const std::filesystem::path &path) {
+    std::string ext = path.extension().string();
+    for (const auto &c : AUDIO_CODECS) {
+        if (ext == c.extension) return &c;
+    }
+    return nullptr;
+}
 
-    // Stop any current playback
-    if (state->playing) {
-        stop_playback(state);
+// Streaming mono S16 reader for any supported codec
+struct AudioDecoder {
+    SNDFILE *sf = nullptr;
+    SF_INFO info = {};
+};
+
+static void audio_decoder_close(AudioDecoder *dec) {
+    if (dec->sf != nullptr) {
+        sf_close(dec->sf);
+        dec->sf = nullptr;
     }
+}
 
-    const VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
-    if (!read_wav_file(note.filepath, state->playback_buffer)) {
-        gtk_label_set_text(GTK_LABEL(state->label), "Failed to read WAV file");
-        return;
+static bool audio_decoder_open(AudioDecoder *dec, const std::string &path) {
+    audio_decoder_close(dec);
+    dec->info = {};
+    dec->sf = sf_open(path.c_str(), SFM_READ, &dec->info);
+    if (dec->sf == nullptr) return false;
+    if (dec->info.channels != NUM_CHANNELS || dec->info.samplerate <= 0) {
+        audio_decoder_close(dec);
+        return false;
     }
+    return true;
+}
 
-    state->playback_offset = 0;
+static size_t audio_decoder_read(AudioDecoder *dec, int16_t *out,
+                                 size_t frames) {
+    sf_count_t n = sf_readf_short(dec->sf, out,
+                                  static_cast<sf_count_t>(frames));
+    return n > 0 ? static_cast<size_t>(n) : 0;
+}
 
-    static const pa_sample_spec spec = {
-        .format = PA_SAMPLE_S16LE,
-        .rate = SAMPLE_RATE,
+static double get_audio_duration(const std::string &path) {
+    AudioDecoder dec;
+    if (!audio_decoder_open(&dec, path)) return 0.0;
+    double seconds = static_cast<double>(dec.info.frames) /
+                     static_cast<double>(dec.info.samplerate);
+    audio_decoder_close(&dec);
+    return seconds;
+}
+
+// Copy up to `frames` frames (all if negative) from `in` to `out`,
+// resampling from the decoder's rate to `out_rate`
+static bool transcode_frames(AudioDecoder *in, sf_count_t frames,
+                             SNDFILE *out, uint32_t out_rate) {
+    auto in_rate = static_cast<uint32_t>(in->info.samplerate);
+    Resampler rs;
+    bool resample = out_rate != in_rate;
+    if (resample) resampler_init(&rs, in_rate, out_rate);
+
+    std::vector<int16_t> buf(CODEC_CHUNK_FRAMES);
+    std::vector<int16_t> resampled(
+        resample ? resampler_max_output(&rs, CODEC_CHUNK_FRAMES) : 0);
+    sf_count_t remaining = frames;
+    while (remaining != 0) {
+        size_t want = buf.size();
+        if (remaining > 0) {
+            want = std::min(want, static_cast<size_t>(remaining));
+        }
+        size_t n = audio_decoder_read(in, buf.data(), want);
+        if (n == 0) break;
+        if (remaining > 0) remaining -= static_cast<sf_count_t>(n);
+
+        const int16_t *samples = buf.data();
+        if (resample) {
+            n = resampler_process(&rs, buf.data(), n, resampled.data(),
+                                  resampled.size());
+            samples = resampled.data();
+        }
+        if (sf_writef_short(out, samples, static_cast<sf_count_t>(n)) !=
+            static_cast<sf_count_t>(n)) {
+            g_warning("Encoding failed: %s", sf_strerror(out));
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t encode_rate(const CodecInfo *codec, uint32_t sample_rate,
+                            uint32_t source_rate) {
+    if (sample_rate != 0) return sample_rate;
+    return codec->sample_rate != 0 ? codec->sample_rate : source_rate;
+}
+
+// Transcode `src` into a new file at `dst`, resampling to `sample_rate`
+// (0 for the codec's own rate or the source rate).  Safe to run off the
+// main thread; it touches nothing but the two files.
+static bool encode_audio_file(const std::string &src, const std::string &dst,
+                              const CodecInfo *codec, uint32_t sample_rate) {
+    AudioDecoder in;
+    if (!audio_decoder_open(&in, src)) return false;
+
+    uint32_t out_rate = encode_rate(
+        codec, sample_rate, static_cast<uint32_t>(in.info.samplerate));
+    SF_INFO out_info = {};
+    out_info.samplerate = static_cast<int>(out_rate);
+    out_info.channels = NUM_CHANNELS;
+    out_info.format = codec->sf_format;
+    SNDFILE *out = sf_open(dst.c_str(), SFM_WRITE, &out_info);
+    if (out == nullptr) {
+        g_warning("Cannot write %s: %s", dst.c_str(), sf_strerror(nullptr));
+        audio_decoder_close(&in);
+        return false;
+    }
+
+    bool ok = transcode_frames(&in, -1, out, out_rate);
+    ok = (sf_close(out) == 0) && ok;
+    audio_decoder_close(&in);
+    return ok;
+}
+
+// Growable in-memory file for libsndfile's virtual I/O
+struct MemoryFile {
+    std::vector<unsigned char> data;
+    sf_count_t pos = 0;
+};
+
+static sf_count_t memfile_length(void *user) {
+    return static_cast<sf_count_t>(static_cast<MemoryFile *>(user)->data.size());
+}
+
+static sf_count_t memfile_seek(sf_count_t offset, int whence, void *user) {
+    auto *mf = static_cast<MemoryFile *>(user);
+    sf_count_t base = whence == SEEK_CUR   ? mf->pos
+                      : whence == SEEK_END ? memfile_length(user)
+                                           : 0;
+    mf->pos = std::max<sf_count_t>(0, base + offset);
+    return mf->pos;
+}
+
+static sf_count_t memfile_read(void *ptr, sf_count_t count, void *user) {
+    auto *mf = static_cast<MemoryFile *>(user);
+    sf_count_t avail = std::max<sf_count_t>(0, memfile_length(user) - mf->pos);
+    count = std::min(count, avail);
+    std::memcpy(ptr, mf->data.data() + mf->pos, static_cast<size_t>(count));
+    mf->pos += count;
+    return count;
+}
+
+static sf_count_t memfile_write(const void *ptr, sf_count_t count,
+                                void *user) {
+    auto *mf = static_cast<MemoryFile *>(user);
+    auto end = static_cast<size_t>(mf->pos + count);
+    if (end > mf->data.size()) mf->data.resize(end);
+    std::memcpy(mf->data.data() + mf->pos, ptr, static_cast<size_t>(count));
+    mf->pos += count;
+    return count;
+}
+
+static sf_count_t memfile_tell(void *user) {
+    return static_cast<MemoryFile *>(user)->pos;
+}
+
+// Encode frames [start, start + frames) of `src` into memory.  Returns
+// null on failure.  Safe to run off the main thread.
+static GBytes *encode_audio_range(const std::string &src, sf_count_t start,
+                                  sf_count_t frames, const CodecInfo *codec,
+                                  uint32_t sample_rate) {
+    AudioDecoder in;
+    if (!audio_decoder_open(&in, src)) return nullptr;
+    if (sf_seek(in.sf, start, SEEK_SET) != start) {
+        audio_decoder_close(&in);
+        return nullptr;
+    }
+
+    uint32_t out_rate = encode_rate(
+        codec, sample_rate, static_cast<uint32_t>(in.info.samplerate));
+    SF_INFO out_info = {};
+    out_info.samplerate = static_cast<int>(out_rate);
+    out_info.channels = NUM_CHANNELS;
+    out_info.format = codec->sf_format;
+    SF_VIRTUAL_IO vio = {memfile_length, memfile_seek, memfile_read,
+                         memfile_write, memfile_tell};
+    auto *mf = new MemoryFile;
+    SNDFILE *out = sf_open_virtual(&vio, SFM_WRITE, &out_info, mf);
+    if (out == nullptr) {
+        delete mf;
+        audio_decoder_close(&in);
+        return nullptr;
+    }
+
+    bool ok = transcode_frames(&in, frames, out, out_rate);
+    ok = (sf_close(out) == 0) && ok;
+    audio_decoder_close(&in);
+    if (!ok) {
+        delete mf;
+        return nullptr;
+    }
+    return g_bytes_new_with_free_func(
+        mf->data.data(), mf->data.size(),
+        [](gpointer data) { delete static_cast<MemoryFile *>(data); }, mf);
+}
+
+// --- Level metering ---
+
+// Peak, RMS, EBU R128 short-term loudness and a clip counter, shared by
+// the recording, dictation and settings preview streams.  The per-block
+// peak/energy/clip scan is vectorised; K-weighting is a pair of biquads.
+// Meters run on the capture thread and publish into MeterLevels, which
+// the UI samples once per rendered frame.
+
+static constexpr double METER_BLOCK_SECONDS = 0.1;
+static constexpr size_t METER_SHORT_TERM_BLOCKS = 30;  // 3 s window
+static constexpr int16_t METER_CLIP_THRESHOLD = 32767;
+
+struct MeterScan {
+    int32_t peak = 0;      // largest |sample|, exact even for INT16_MIN
+    uint64_t sum_sq = 0;   // sum of squares
+    uint64_t clipped = 0;  // samples at full scale
+};
+
+using MeterScanKernel = void (*)(const int16_t *, size_t, MeterScan *);
+
+static void meter_scan_scalar(const int16_t *data, size_t n, MeterScan *out) {
+    int32_t peak = out->peak;
+    uint64_t sum_sq = out->sum_sq;
+    uint64_t clipped = out->clipped;
+    for (size_t i = 0; i < n; i++) {
+        int32_t v = data[i];
+        int32_t a = v < 0 ? -v : v;
+        peak = std::max(peak, a);
+        sum_sq += static_cast<uint64_t>(static_cast<int64_t>(v) * v);
+        clipped += (a >= METER_CLIP_THRESHOLD);
+    }
+    out->peak = peak;
+    out->sum_sq = sum_sq;
+    out->clipped = clipped;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Squares are taken of samples clamped to ±32767 so a pair sum can't
+// overflow _mm_madd_epi16; INT16_MIN hits are counted and corrected for
+// afterwards.  Clip and INT16_MIN hits are tallied per 16-bit lane and
+// folded into 64-bit totals before a lane can wrap.
+static constexpr uint64_t METER_INT16_MIN_SQ_FIXUP = 32768ull * 32768 - 32767ull * 32767;
+static constexpr size_t METER_LANE_FLUSH_VECTORS = 32767;
+
+__attribute__((target("sse2")))
+static void meter_scan_sse2(const int16_t *data, size_t n, MeterScan *out) {
+    const __m128i lo_clamp = _mm_set1_epi16(-32767);
+    const __m128i clip_hi = _mm_set1_epi16(METER_CLIP_THRESHOLD - 1);
+    const __m128i clip_lo = _mm_set1_epi16(-METER_CLIP_THRESHOLD + 1);
+    const __m128i int16_min = _mm_set1_epi16(INT16_MIN);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vmax = zero, vmin = zero;
+    __m128i acc = zero;  // 2 × uint64
+    uint64_t clipped = 0, min_hits = 0;
+
+    size_t i = 0;
+    while (i + 8 <= n) {
+        __m128i clip_lanes = zero, min_lanes = zero;
+        size_t vectors = std::min((n - i) / 8, METER_LANE_FLUSH_VECTORS);
+        for (size_t v = 0; v < vectors; v++, i += 8) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            vmax = _mm_max_epi16(vmax, x);
+            vmin = _mm_min_epi16(vmin, x);
+            __m128i xs = _mm_max_epi16(x, lo_clamp);
+            __m128i sq = _mm_madd_epi16(xs, xs);  // 4 × non-negative int32
+            acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, zero));
+            acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, zero));
+            // Comparison masks are -1, so subtracting counts hits
+            clip_lanes = _mm_sub_epi16(clip_lanes, _mm_cmpgt_epi16(xs, clip_hi));
+            clip_lanes = _mm_sub_epi16(clip_lanes, _mm_cmplt_epi16(xs, clip_lo));
+            min_lanes = _mm_sub_epi16(min_lanes, _mm_cmpeq_epi16(x, int16_min));
+        }
+        alignas(16) uint16_t cl[8], ml[8];
+        _mm_store_si128(reinterpret_cast<__m128i *>(cl), clip_lanes);
+        _mm_store_si128(reinterpret_cast<__m128i *>(ml), min_lanes);
+        for (int k = 0; k < 8; k++) {
+            clipped += cl[k];
+            min_hits += ml[k];
+        }
+    }
+
+    alignas(16) int16_t mx[8], mn[8];
+    alignas(16) uint64_t sums[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(mx), vmax);
+    _mm_store_si128(reinterpret_cast<__m128i *>(mn), vmin);
+    _mm_store_si128(reinterpret_cast<__m128i *>(sums), acc);
+    for (int k = 0; k < 8; k++) {
+        out->peak = std::max({out->peak, static_cast<int32_t>(mx[k]),
+                              -static_cast<int32_t>(mn[k])});
+    }
+    out->sum_sq += sums[0] + sums[1] + min_hits * METER_INT16_MIN_SQ_FIXUP;
+    out->clipped += clipped;
+    meter_scan_scalar(data + i, n - i, out);
+}
+
+__attribute__((target("avx2")))
+static void meter_scan_avx2(const int16_t *data, size_t n, MeterScan *out) {
+    const __m256i lo_clamp = _mm256_set1_epi16(-32767);
+    const __m256i full = _mm256_set1_epi16(METER_CLIP_THRESHOLD);
+    const __m256i int16_min = _mm256_set1_epi16(INT16_MIN);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i vmax = zero, vmin = zero;
+    __m256i acc = zero;  // 4 × uint64
+    uint64_t clipped = 0, min_hits = 0;
+
+    size_t i = 0;
+    while (i + 16 <= n) {
+        __m256i clip_lanes = zero, min_lanes = zero;
+        size_t vectors = std::min((n - i) / 16, METER_LANE_FLUSH_VECTORS);
+        for (size_t v = 0; v < vectors; v++, i += 16) {
+            __m256i x = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(data + i));
+            vmax = _mm256_max_epi16(vmax, x);
+            vmin = _mm256_min_epi16(vmin, x);
+            __m256i xs = _mm256_max_epi16(x, lo_clamp);
+            __m256i sq = _mm256_madd_epi16(xs, xs);
+            acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(
+                                            _mm256_castsi256_si128(sq)));
+            acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(
+                                            _mm256_extracti128_si256(sq, 1)));
+            clip_lanes = _mm256_sub_epi16(
+                clip_lanes, _mm256_cmpeq_epi16(_mm256_abs_epi16(xs), full));
+            min_lanes = _mm256_sub_epi16(min_lanes,
+                                         _mm256_cmpeq_epi16(x, int16_min));
+        }
+        alignas(32) uint16_t cl[16], ml[16];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(cl), clip_lanes);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(ml), min_lanes);
+        for (int k = 0; k < 16; k++) {
+            clipped += cl[k];
+            min_hits += ml[k];
+        }
+    }
+
+    alignas(32) int16_t mx[16], mn[16];
+    alignas(32) uint64_t sums[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(mx), vmax);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(mn), vmin);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(sums), acc);
+    for (int k = 0; k < 16; k++) {
+        out->peak = std::max({out->peak, static_cast<int32_t>(mx[k]),
+                              -static_cast<int32_t>(mn[k])});
+    }
+    out->sum_sq += sums[0] + sums[1] + sums[2] + sums[3] +
+                   min_hits * METER_INT16_MIN_SQ_FIXUP;
+    out->clipped += clipped;
+    meter_scan_scalar(data + i, n - i, out);
+}
+#endif
+
+static MeterScanKernel select_meter_scan_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return meter_scan_avx2;
+    if (__builtin_cpu_supports("sse2")) return meter_scan_sse2;
+#endif
+    return meter_scan_scalar;
+}
+
+struct Biquad {
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    double z1 = 0.0, z2 = 0.0;
+};
+
+static double biquad_run(Biquad *f, double x) {
+    double y = f->b0 * x + f->z1;
+    f->z1 = f->b1 * x - f->a1 * y + f->z2;
+    f->z2 = f->b2 * x - f->a2 * y;
+    return y;
+}
+
+struct LevelMeter {
+    MeterScanKernel scan = nullptr;
+    Biquad shelf, highpass;  // BS.1770 K-weighting
+    size_t block_len = 0;
+    size_t block_fill = 0;
+    double block_energy = 0.0;
+    double blocks[METER_SHORT_TERM_BLOCKS] = {};
+    size_t block_count = 0;
+    size_t block_index = 0;
+
+    // Latest readings
+    double peak = 0.0;     // last fragment, 0..1 of full scale
+    double rms = 0.0;      // last fragment, 0..1 of full scale
+    double lufs = -70.0;   // short-term (3 s) loudness
+    uint64_t clipped = 0;  // samples at full scale since meter_reset
+    double display = 0.0;  // peak with release decay, for level bars
+};
+
+// K-weighting coefficients for any sample rate (ITU-R BS.1770-4)
+static void meter_init(LevelMeter *m, uint32_t sample_rate) {
+    static const MeterScanKernel kernel = select_meter_scan_kernel();
+    m->scan = kernel;
+
+    double fs = static_cast<double>(sample_rate);
+    double f0 = 1681.974450955533, gain_db = 3.999843853973347,
+           q = 0.7071752369554196;
+    double k = std::tan(M_PI * f0 / fs);
+    double vh = std::pow(10.0, gain_db / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    m->shelf.b1 = 2.0 * (k * k - vh) / a0;
+    m->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    m->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    m->shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(M_PI * f0 / fs);
+    a0 = 1.0 + k / q + k * k;
+    m->highpass.b0 = 1.0;
+    m->highpass.b1 = -2.0;
+    m->highpass.b2 = 1.0;
+    m->highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+    m->highpass.a2 = (1.0 - k / q + k * k) / a0;
+
+    m->block_len = static_cast<size_t>(fs * METER_BLOCK_SECONDS);
+}
+
+static void meter_reset(LevelMeter *m) {
+    m->shelf.z1 = m->shelf.z2 = 0.0;
+    m->highpass.z1 = m->highpass.z2 = 0.0;
+    m->block_fill = 0;
+    m->block_energy = 0.0;
+    m->block_count = 0;
+    m->block_index = 0;
+    m->peak = 0.0;
+    m->rms = 0.0;
+    m->lufs = -70.0;
+    m->clipped = 0;
+    m->display = 0.0;
+}
+
+static double to_dbfs(double level) {
+    return level > 0.0 ? 20.0 * std::log10(level) : -INFINITY;
+}
+
+static void meter_process(LevelMeter *m, const int16_t *data, size_t n) {
+    if (n == 0) return;
+
+    MeterScan scan;
+    m->scan(data, n, &scan);
+    m->peak = static_cast<double>(scan.peak) / 32768.0;
+    m->rms = std::sqrt(static_cast<double>(scan.sum_sq) /
+                       static_cast<double>(n)) / 32768.0;
+    m->clipped += scan.clipped;
+
+    if (m->peak >= m->display) {
+        m->display = m->peak;
+    } else {
+        m->display = m->display * DECAY_FACTOR + m->peak * (1.0 - DECAY_FACTOR);
+    }
+
+    // Short-term loudness over 100 ms blocks of K-weighted energy
+    for (size_t i = 0; i < n; i++) {
+        double x = static_cast<double>(data[i]) / 32768.0;
+        double y = biquad_run(&m->highpass, biquad_run(&m->shelf, x));
+        m->block_energy += y * y;
+        if (++m->block_fill == m->block_len) {
+            m->blocks[m->block_index] =
+                m->block_energy / static_cast<double>(m->block_len);
+            m->block_index = (m->block_index + 1) % METER_SHORT_TERM_BLOCKS;
+            m->block_count = std::min(m->block_count + 1,
+                                      METER_SHORT_TERM_BLOCKS);
+            m->block_fill = 0;
+            m->block_energy = 0.0;
+
+            double sum = 0.0;
+            for (size_t b = 0; b < m->block_count; b++) sum += m->blocks[b];
+            double mean = sum / static_cast<double>(m->block_count);
+            m->lufs = mean > 1e-10 ? -0.691 + 10.0 * std::log10(mean)
+                                   : -70.0;
+        }
+    }
+}
+
+// Latest readings, written by the capture thread and read by the UI
+struct MeterLevels {
+    std::atomic<float> display{0.0f};
+    std::atomic<float> peak{0.0f};
+    std::atomic<float> lufs{-70.0f};
+    std::atomic<uint64_t> clipped{0};
+};
+
+static void meter_publish(const LevelMeter *m, MeterLevels *out) {
+    out->display.store(static_cast<float>(m->display),
+                       std::memory_order_relaxed);
+    out->peak.store(static_cast<float>(m->peak), std::memory_order_relaxed);
+    out->lufs.store(static_cast<float>(m->lufs), std::memory_order_relaxed);
+    out->clipped.store(m->clipped, std::memory_order_relaxed);
+}
+
+// A capture stream on the real-time thread together with its ring
+struct CaptureTap {
+    pa_stream *stream = nullptr;
+    SpscRing ring;
+    std::atomic<bool> failed{false};  // set from the capture thread
+
+    // Set before open_capture.  A tap that isn't buffered only meters.
+    bool buffered = true;
+    bool metered = false;
+    LevelMeter meter;     // capture thread only while the stream is open
+    MeterLevels levels;
+};
+
+// --- Voice activity detection ---
+
+// Gates the realtime uplink so silence isn't streamed.  Each 16 ms frame
+// is classified on energy above a tracked noise floor and on spectral
+// flatness (speech is harmonic, room noise is flat).  Speech keeps the
+// gate open for a hangover period, and the frames preceding an onset are
+// replayed so soft word starts aren't clipped.
+
+static constexpr size_t VAD_FRAME_SAMPLES = 256;        // 16 ms at 16 kHz
+static constexpr size_t VAD_PREROLL_FRAMES = 20;        // 320 ms
+static constexpr uint32_t VAD_HANGOVER_FRAMES = 40;     // 640 ms
+static constexpr double VAD_MIN_SPEECH_DB = -55.0;
+static constexpr double VAD_SPEECH_MARGIN_DB = 6.0;     // with low flatness
+static constexpr double VAD_LOUD_MARGIN_DB = 20.0;      // with moderate flatness
+static constexpr double VAD_MAX_SPEECH_FLATNESS = 0.35;
+static constexpr double VAD_MAX_LOUD_FLATNESS = 0.5;    // white noise is ~0.56
+static constexpr double VAD_BAND_LOW_HZ = 300.0;
+static constexpr double VAD_BAND_HIGH_HZ = 4000.0;
+
+struct VoiceGate {
+    uint32_t sample_rate = 0;
+    std::vector<float> window;           // Hann
+    std::vector<float> twiddle_re, twiddle_im;
+    std::vector<uint32_t> bit_reverse;
+    std::vector<float> fft_re, fft_im;
+    size_t band_lo = 0, band_hi = 0;
+
+    std::vector<int16_t> frame;          // partial frame being filled
+    size_t frame_fill = 0;
+    std::vector<int16_t> preroll;        // ring of VAD_PREROLL_FRAMES frames
+    size_t preroll_head = 0;             // oldest frame
+    size_t preroll_count = 0;
+
+    double noise_floor_db = -60.0;
+    uint32_t hangover = 0;
+    bool open = false;
+
+    uint64_t frames_seen = 0;
+    uint64_t frames_sent = 0;
+};
+
+static void vad_init(VoiceGate *g, uint32_t sample_rate) {
+    const size_t n = VAD_FRAME_SAMPLES;
+    g->sample_rate = sample_rate;
+
+    g->window.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        g->window[i] = static_cast<float>(
+            0.5 - 0.5 * std::cos(2.0 * M_PI * static_cast<double>(i) /
+                                 static_cast<double>(n)));
+    }
+
+    g->twiddle_re.resize(n / 2);
+    g->twiddle_im.resize(n / 2);
+    for (size_t k = 0; k < n / 2; k++) {
+        double a = -2.0 * M_PI * static_cast<double>(k) /
+                   static_cast<double>(n);
+        g->twiddle_re[k] = static_cast<float>(std::cos(a));
+        g->twiddle_im[k] = static_cast<float>(std::sin(a));
+    }
+
+    unsigned bits = 0;
+    while ((size_t{1} << bits) < n) bits++;
+    g->bit_reverse.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t r = 0;
+        for (unsigned b = 0; b < bits; b++) {
+            if (i & (1u << b)) r |= 1u << (bits - 1 - b);
+        }
+        g->bit_reverse[i] = r;
+    }
+
+    g->fft_re.resize(n);
+    g->fft_im.resize(n);
+    double bin_hz = static_cast<double>(sample_rate) / static_cast<double>(n);
+    g->band_lo = static_cast<size_t>(VAD_BAND_LOW_HZ / bin_hz);
+    g->band_hi = std::min(static_cast<size_t>(VAD_BAND_HIGH_HZ / bin_hz),
+                          n / 2 - 1);
+
+    g->frame.resize(n);
+    g->preroll.resize(n * VAD_PREROLL_FRAMES);
+}
+
+static void vad_reset(VoiceGate *g) {
+    g->frame_fill = 0;
+    g->preroll_head = 0;
+    g->preroll_count = 0;
+    g->noise_floor_db = -60.0;
+    g->hangover = 0;
+    g->open = false;
+    g->frames_seen = 0;
+    g->frames_sent = 0;
+}
+
+// In-place radix-2 FFT over fft_re/fft_im
+static void vad_fft(VoiceGate *g) {
+    const size_t n = VAD_FRAME_SAMPLES;
+    float *re = g->fft_re.data();
+    float *im = g->fft_im.data();
+    for (size_t i = 0; i < n; i++) {
+        size_t j = g->bit_reverse[i];
+        if (j > i) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t half = len / 2;
+        size_t step = n / len;
+        for (size_t start = 0; start < n; start += len) {
+            for (size_t k = 0; k < half; k++) {
+                float wr = g->twiddle_re[k * step];
+                float wi = g->twiddle_im[k * step];
+                size_t a = start + k, b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+static bool vad_classify(VoiceGate *g, const int16_t *frame) {
+    const size_t n = VAD_FRAME_SAMPLES;
+    double energy = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        float x = static_cast<float>(frame[i]) / 32768.0f;
+        energy += static_cast<double>(x) * x;
+        g->fft_re[i] = x * g->window[i];
+        g->fft_im[i] = 0.0f;
+    }
+    double energy_db = 10.0 * std::log10(energy / static_cast<double>(n) +
+                                         1e-12);
+
+    // Spectral flatness over the speech band: geometric / arithmetic mean
+    vad_fft(g);
+    double log_sum = 0.0, sum = 0.0;
+    for (size_t k = g->band_lo; k <= g->band_hi; k++) {
+        double p = static_cast<double>(g->fft_re[k]) * g->fft_re[k] +
+                   static_cast<double>(g->fft_im[k]) * g->fft_im[k] + 1e-12;
+        log_sum += std::log(p);
+        sum += p;
+    }
+    double bins = static_cast<double>(g->band_hi - g->band_lo + 1);
+    double flatness = std::exp(log_sum / bins) / (sum / bins);
+
+    double margin = energy_db - g->noise_floor_db;
+    bool speech = energy_db > VAD_MIN_SPEECH_DB &&
+                  ((margin > VAD_SPEECH_MARGIN_DB &&
+                    flatness < VAD_MAX_SPEECH_FLATNESS) ||
+                   (margin > VAD_LOUD_MARGIN_DB &&
+                    flatness < VAD_MAX_LOUD_FLATNESS));
+
+    // Noise floor falls quickly and creeps up slowly.  It learns from
+    // anything noise-like, so a fan switching on doesn't hold the gate open
+    if (!speech || flatness >= VAD_MAX_SPEECH_FLATNESS) {
+        double rate = energy_db < g->noise_floor_db ? 0.3 : 0.05;
+        g->noise_floor_db += (energy_db - g->noise_floor_db) * rate;
+        g->noise_floor_db = std::clamp(g->noise_floor_db, -90.0, -20.0);
+    }
+    return speech;
+}
+
+// Appends the audio that should go upstream to `out`, and for each
+// frame of it whether that frame itself was classified as speech
+static void vad_process(VoiceGate *g, const int16_t *samples, size_t count,
+                        std::vector<int16_t> &out,
+                        std::vector<uint8_t> &speech) {
+    const size_t n = VAD_FRAME_SAMPLES;
+    while (count > 0) {
+        size_t take = std::min(count, n - g->frame_fill);
+        std::memcpy(g->frame.data() + g->frame_fill, samples,
+                    take * sizeof(int16_t));
+        g->frame_fill += take;
+        samples += take;
+        count -= take;
+        if (g->frame_fill < n) break;
+        g->frame_fill = 0;
+        g->frames_seen++;
+
+        bool voiced = vad_classify(g, g->frame.data());
+        if (voiced) {
+            g->hangover = VAD_HANGOVER_FRAMES;
+            if (!g->open) {
+                // Onset: replay the buffered lead-in first
+                for (size_t f = 0; f < g->preroll_count; f++) {
+                    size_t slot = (g->preroll_head + f) % VAD_PREROLL_FRAMES;
+                    const int16_t *src = g->preroll.data() + slot * n;
+                    out.insert(out.end(), src, src + n);
+                }
+                speech.insert(speech.end(), g->preroll_count, 0);
+                g->frames_sent += g->preroll_count;
+                g->preroll_count = 0;
+                g->preroll_head = 0;
+                g->open = true;
+            }
+        } else if (g->open && g->hangover > 0) {
+            g->hangover--;
+        } else {
+            g->open = false;
+        }
+
+        if (g->open) {
+            out.insert(out.end(), g->frame.begin(), g->frame.end());
+            speech.push_back(voiced ? 1 : 0);
+            g->frames_sent++;
+        } else {
+            size_t slot = (g->preroll_head + g->preroll_count) %
+                          VAD_PREROLL_FRAMES;
+            std::memcpy(g->preroll.data() + slot * n, g->frame.data(),
+                        n * sizeof(int16_t));
+            if (g->preroll_count < VAD_PREROLL_FRAMES) {
+                g->preroll_count++;
+            } else {
+                g->preroll_head = (g->preroll_head + 1) % VAD_PREROLL_FRAMES;
+            }
+        }
+    }
+}
+
+// --- Key injection ---
+
+// Types text by emitting key events directly, with no process per flush.
+// Events go to a running ydotoold over its socket, or else to a virtual
+// keyboard of our own on /dev/uinput.  Either way the compositor decodes
+// keycodes with its own layout, so, as with ydotool, text is typed as if
+// on a US keyboard.  Characters the keymap can't produce are
+// transliterated where there is an obvious ASCII equivalent and skipped
+// otherwise.
+
+enum class KeyTransport { NONE, YDOTOOLD, UINPUT };
+
+struct KeyInjector {
+    KeyTransport transport = KeyTransport::NONE;
+    int fd = -1;
+    std::vector<input_event> events;  // reused between flushes
+    size_t skipped = 0;               // characters with no key, for logging
+};
+
+struct KeyStroke {
+    uint16_t code;  // 0 if the character can't be typed
+    bool shift;
+};
+
+struct UsKey {
+    char plain;
+    char shifted;
+    uint16_t code;
+};
+
+static const UsKey US_KEYS[] = {
+    {'1', '!', KEY_1}, {'2', '@', KEY_2}, {'3', '#', KEY_3},
+    {'4', '$', KEY_4}, {'5', '%', KEY_5}, {'6', '^', KEY_6},
+    {'7', '&', KEY_7}, {'8', '*', KEY_8}, {'9', '(', KEY_9},
+    {'0', ')', KEY_0}, {'-', '_', KEY_MINUS}, {'=', '+', KEY_EQUAL},
+    {'q', 'Q', KEY_Q}, {'w', 'W', KEY_W}, {'e', 'E', KEY_E},
+    {'r', 'R', KEY_R}, {'t', 'T', KEY_T}, {'y', 'Y', KEY_Y},
+    {'u', 'U', KEY_U}, {'i', 'I', KEY_I}, {'o', 'O', KEY_O},
+    {'p', 'P', KEY_P}, {'[', '{', KEY_LEFTBRACE}, {']', '}', KEY_RIGHTBRACE},
+    {'a', 'A', KEY_A}, {'s', 'S', KEY_S}, {'d', 'D', KEY_D},
+    {'f', 'F', KEY_F}, {'g', 'G', KEY_G}, {'h', 'H', KEY_H},
+    {'j', 'J', KEY_J}, {'k', 'K', KEY_K}, {'l', 'L', KEY_L},
+    {';', ':', KEY_SEMICOLON}, {'\'', '"', KEY_APOSTROPHE},
+    {'`', '~', KEY_GRAVE}, {'\\', '|', KEY_BACKSLASH},
+    {'z', 'Z', KEY_Z}, {'x', 'X', KEY_X}, {'c', 'C', KEY_C},
+    {'v', 'V', KEY_V}, {'b', 'B', KEY_B}, {'n', 'N', KEY_N},
+    {'m', 'M', KEY_M}, {',', '<', KEY_COMMA}, {'.', '>', KEY_DOT},
+    {'/', '?', KEY_SLASH}, {' ', ' ', KEY_SPACE}, {'\n', '\n', KEY_ENTER},
+    {'\t', '\t', KEY_TAB},
+};
+
+static KeyStroke key_for_char(char c) {
+    static const auto table = [] {
+        std::array<KeyStroke, 128> t{};
+        for (const UsKey &k : US_KEYS) {
+            t[static_cast<size_t>(k.shifted)] = {k.code, k.shifted != k.plain};
+            t[static_cast<size_t>(k.plain)] = {k.code, false};
+        }
+        return t;
+    }();
+    auto u = static_cast<unsigned char>(c);
+    return u < table.size() ? table[u] : KeyStroke{0, false};
+}
+
+// ASCII stand-ins for punctuation the transcriber likes to produce
+static const char *transliterate(gunichar ch) {
+    switch (ch) {
+    case 0x00A0: return " ";
+    case 0x2018: case 0x2019: return "'";
+    case 0x201C: case 0x201D: return "\"";
+    case 0x2013: case 0x2014: return "-";
+    case 0x2026: return "...";
+    default: return nullptr;
+    }
+}
+
+static void key_event(KeyInjector *k, uint16_t type, uint16_t code,
+                      int32_t value) {
+    input_event ev{};
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+    k->events.push_back(ev);
+}
+
+static void key_tap(KeyInjector *k, KeyStroke key) {
+    if (key.shift) {
+        key_event(k, EV_KEY, KEY_LEFTSHIFT, 1);
+        key_event(k, EV_SYN, SYN_REPORT, 0);
+    }
+    key_event(k, EV_KEY, key.code, 1);
+    key_event(k, EV_SYN, SYN_REPORT, 0);
+    key_event(k, EV_KEY, key.code, 0);
+    key_event(k, EV_SYN, SYN_REPORT, 0);
+    if (key.shift) {
+        key_event(k, EV_KEY, KEY_LEFTSHIFT, 0);
+        key_event(k, EV_SYN, SYN_REPORT, 0);
+    }
+}
+
+static std::string ydotoold_socket_path() {
+    const char *env = g_getenv("YDOTOOL_SOCKET");
+    if (env != nullptr && env[0] != '\0') return env;
+    const char *runtime = g_getenv("XDG_RUNTIME_DIR");
+    if (runtime != nullptr) {
+        std::string path = std::string(runtime) + "/.ydotool_socket";
+        if (std::filesystem::exists(path)) return path;
+    }
+    return "/tmp/.ydotool_socket";
+}
+
+// ydotoold takes one input_event per datagram and replays it on its own
+// uinput device
+static bool key_injector_open_ydotoold(KeyInjector *k) {
+    std::string path = ydotoold_socket_path();
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return false;
+    }
+    k->fd = fd;
+    k->transport = KeyTransport::YDOTOOLD;
+    return true;
+}
+
+static bool key_injector_open_uinput(KeyInjector *k) {
+    int fd = open("/dev/uinput", O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    bool ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0 &&
+              ioctl(fd, UI_SET_EVBIT, EV_SYN) == 0 &&
+              ioctl(fd, UI_SET_KEYBIT, KEY_LEFTSHIFT) == 0;
+    for (const UsKey &key : US_KEYS) {
+        ok = ok && ioctl(fd, UI_SET_KEYBIT, key.code) == 0;
+    }
+
+    uinput_setup setup{};
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = 0x1209;  // pid.codes test range
+    setup.id.product = 0x0001;
+    g_strlcpy(setup.name, "Linscribe virtual keyboard", sizeof(setup.name));
+    ok = ok && ioctl(fd, UI_DEV_SETUP, &setup) == 0 &&
+         ioctl(fd, UI_DEV_CREATE) == 0;
+    if (!ok) {
+        close(fd);
+        return false;
+    }
+    k->fd = fd;
+    k->transport = KeyTransport::UINPUT;
+    return true;
+}
+
+static void key_injector_close(KeyInjector *k) {
+    if (k->fd >= 0) {
+        if (k->transport == KeyTransport::UINPUT) {
+            ioctl(k->fd, UI_DEV_DESTROY);
+        }
+        close(k->fd);
+    }
+    k->fd = -1;
+    k->transport = KeyTransport::NONE;
+    k->events.clear();
+}
+
+static bool key_injector_send(KeyInjector *k) {
+    bool ok = true;
+    if (k->transport == KeyTransport::UINPUT) {
+        // uinput takes any number of events per write
+        size_t bytes = k->events.size() * sizeof(input_event);
+        ok = write_all(k->fd, k->events.data(), bytes);
+    } else {
+        for (const input_event &ev : k->events) {
+            if (send(k->fd, &ev, sizeof(ev), 0) != sizeof(ev)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    k->events.clear();
+    return ok;
+}
+
+static bool key_injector_type(KeyInjector *k, const char *text, size_t len) {
+    if (k->fd < 0) return false;
+
+    const char *end = text + len;
+    for (const char *p = text; p < end; p = g_utf8_next_char(p)) {
+        auto u = static_cast<unsigned char>(*p);
+        if (u < 0x80) {
+            KeyStroke key = key_for_char(*p);
+            if (key.code != 0) key_tap(k, key);
+            continue;
+        }
+        const char *ascii = transliterate(g_utf8_get_char(p));
+        if (ascii == nullptr) {
+            k->skipped++;
+            continue;
+        }
+        for (; *ascii != '\0'; ascii++) key_tap(k, key_for_char(*ascii));
+    }
+    return key_injector_send(k);
+}
+
+// --- Typing queue ---
+
+// Text on its way from the main loop to the typing worker.  The queue is
+// an intrusive linked list (Vyukov's MPSC design): pushing is one atomic
+// exchange and popping never touches the producer's end, so the main
+// loop never waits on a keystroke.  The worker only takes a mutex to
+// sleep when the queue is empty.
+
+struct TypingItem {
+    enum Kind { TEXT, BACKEND, QUIT };
+
+    std::atomic<TypingItem *> next{nullptr};
+    Kind kind = TEXT;
+    uint64_t generation = 0;  // dictation the text belongs to
+    std::string text;
+    TypingTool tool = TypingTool::NONE;  // BACKEND only
+    KeyInjector keys;                    // BACKEND only, moved to the worker
+};
+
+struct TypingQueue {
+    std::atomic<TypingItem *> head{nullptr};  // last pushed, producer side
+    TypingItem *tail = nullptr;               // consumed marker, worker side
+    GMutex lock;
+    GCond wake;
+    std::atomic<bool> sleeping{false};
+};
+
+// Only call while the worker isn't running
+static void typing_queue_init(TypingQueue *q) {
+    q->tail = new TypingItem;
+    q->head.store(q->tail, std::memory_order_relaxed);
+    g_mutex_init(&q->lock);
+    g_cond_init(&q->wake);
+}
+
+static void typing_queue_clear(TypingQueue *q) {
+    while (q->tail != nullptr) {
+        TypingItem *next = q->tail->next.load(std::memory_order_relaxed);
+        key_injector_close(&q->tail->keys);
+        delete q->tail;
+        q->tail = next;
+    }
+    q->head.store(nullptr, std::memory_order_relaxed);
+    g_mutex_clear(&q->lock);
+    g_cond_clear(&q->wake);
+}
+
+static void typing_queue_push(TypingQueue *q, TypingItem *item) {
+    TypingItem *prev = q->head.exchange(item, std::memory_order_acq_rel);
+    prev->next.store(item, std::memory_order_seq_cst);
+    if (q->sleeping.load(std::memory_order_seq_cst)) {
+        g_mutex_lock(&q->lock);
+        g_cond_signal(&q->wake);
+        g_mutex_unlock(&q->lock);
+    }
+}
+
+// Worker side — moves the next item's payload into `out`, false if empty
+static bool typing_queue_pop(TypingQueue *q, TypingItem *out) {
+    TypingItem *next = q->tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) return false;
+    out->kind = next->kind;
+    out->generation = next->generation;
+    out->text = std::move(next->text);
+    out->tool = next->tool;
+    out->keys = std::move(next->keys);
+    next->keys.fd = -1;
+    delete q->tail;
+    q->tail = next;  // becomes the new marker
+    return true;
+}
+
+// Worker side — blocks until an item is available
+static void typing_queue_wait(TypingQueue *q, TypingItem *out) {
+    while (!typing_queue_pop(q, out)) {
+        g_mutex_lock(&q->lock);
+        q->sleeping.store(true, std::memory_order_seq_cst);
+        while (q->tail->next.load(std::memory_order_seq_cst) == nullptr) {
+            g_cond_wait(&q->wake, &q->lock);
+        }
+        q->sleeping.store(false, std::memory_order_relaxed);
+        g_mutex_unlock(&q->lock);
+    }
+}
+
+// Owned by the worker thread except for the atomics
+struct TypingWorker {
+    GThread *thread = nullptr;
+    TypingQueue queue;
+    std::atomic<uint64_t> generation{0};  // bumped to cancel queued text
+    std::atomic<size_t> backlog{0};       // bytes queued but not yet typed
+    size_t peak_backlog = 0;              // main thread, per dictation
+    std::atomic<TypingTool> failed_tool{TypingTool::NONE};  // for the probe
+
+    // Worker thread only
+    TypingTool tool = TypingTool::NONE;
+    KeyInjector keys;
+    xdo_t *xdo = nullptr;
+    std::string unsent;  // held while there is no working backend
+    uint64_t unsent_generation = 0;
+    int unsent_attempts = 0;  // backends that failed on it
+};
+
+// --- Session setup pre-roll ---
+
+// Audio captured between ws_connect() and session.updated is held here
+// and sent in order once the session is ready, so nothing said right
+// after the hotkey is lost.  If setup takes longer than
+// WS_PREROLL_SECONDS the oldest audio is dropped.
+static constexpr size_t WS_PREROLL_SECONDS = 15;
+static constexpr size_t WS_PREROLL_SEND_SAMPLES = WS_SAMPLE_RATE / 10;
+
+struct PrerollBuffer {
+    std::vector<int16_t> buf;
+    size_t start = 0;  // oldest sample
+    size_t size = 0;
+    size_t dropped = 0;
+};
+
+static void preroll_reset(PrerollBuffer *p, size_t capacity) {
+    if (p->buf.size() != capacity) p->buf.assign(capacity, 0);
+    p->start = 0;
+    p->size = 0;
+    p->dropped = 0;
+}
+
+// Append, overwriting the oldest samples when full
+static void preroll_push(PrerollBuffer *p, const int16_t *data, size_t count) {
+    size_t cap = p->buf.size();
+    if (cap == 0) return;
+    if (count > cap) {
+        p->dropped += count - cap;
+        data += count - cap;
+        count = cap;
+    }
+    size_t overflow = p->size + count > cap ? p->size + count - cap : 0;
+    p->start = (p->start + overflow) % cap;
+    p->size -= overflow;
+    p->dropped += overflow;
+
+    size_t end = (p->start + p->size) % cap;
+    size_t first = std::min(count, cap - end);
+    std::memcpy(p->buf.data() + end, data, first * sizeof(int16_t));
+    std::memcpy(p->buf.data(), data + first, (count - first) * sizeof(int16_t));
+    p->size += count;
+}
+
+// --- Realtime uplink queue ---
+
+// Gated audio waits here, one VAD frame per slot, until the socket can
+// take it.  Nothing is handed to libsoup while the kernel send queue is
+// above a high-water mark, so libsoup's own queue stays empty and the
+// backlog is visible here.  When it exceeds the session's latency
+// budget, lead-in and hangover frames are dropped first and the oldest
+// speech after that: for a live transcript a dropped word is better
+// than falling seconds behind.  Backlog frames, audio held while the
+// session was being set up, are exempt: they are neither counted as lag
+// nor shed, since not losing them is the point of holding them.
+
+static constexpr size_t UPLINK_QUEUE_SECONDS = 10;  // plus any backlog
+static constexpr int UPLINK_BUDGET_DICTATION_MS = 1500;
+static constexpr int UPLINK_BUDGET_LIVE_MS = 5000;
+static constexpr int UPLINK_SOCKET_HIGH_WATER = 16 * 1024;  // bytes
+static constexpr size_t UPLINK_MAX_MESSAGE_SLOTS = 64;      // ~1 s coalesced
+static constexpr int UPLINK_LAG_SHOW_MS = 500;  // below this the UI is quiet
+
+struct UplinkSlot {
+    gint64 queued_us;
+    bool speech;   // classified as speech, not lead-in or hangover
+    bool backlog;  // held during session setup, exempt from the budget
+};
+
+struct UplinkQueue {
+    std::vector<int16_t> audio;  // VAD_FRAME_SAMPLES per slot
+    std::vector<UplinkSlot> slots;
+    size_t head = 0;
+    size_t count = 0;
+    size_t backlog = 0;            // backlog slots among `count`
+    uint64_t dropped_silence = 0;  // slots
+    uint64_t dropped_speech = 0;
+    uint64_t backlog_sent = 0;     // since the backlog was last reported
+    uint64_t backlog_dropped = 0;
+    gint64 max_age_us = 0;         // oldest frame at send time
+};
+
+static void uplink_reset(UplinkQueue *q, size_t capacity) {
+    if (q->slots.size() != capacity) {
+        q->slots.assign(capacity, UplinkSlot{0, false, false});
+        q->audio.assign(capacity * VAD_FRAME_SAMPLES, 0);
+    }
+    q->head = 0;
+    q->count = 0;
+    q->backlog = 0;
+    q->dropped_silence = 0;
+    q->dropped_speech = 0;
+    q->backlog_sent = 0;
+    q->backlog_dropped = 0;
+    q->max_age_us = 0;
+}
+
+static void uplink_count_drop(UplinkQueue *q, const UplinkSlot &slot) {
+    if (slot.backlog) {
+        q->backlog--;
+        q->backlog_dropped++;
+    } else if (slot.speech) {
+        q->dropped_speech++;
+    } else {
+        q->dropped_silence++;
+    }
+}
+
+// Append one VAD frame, dropping the oldest when full
+static void uplink_push(UplinkQueue *q, const int16_t *frame, bool speech,
+                        bool backlog, gint64 now) {
+    size_t cap = q->slots.size();
+    if (cap == 0) return;
+    if (q->count == cap) {
+        uplink_count_drop(q, q->slots[q->head]);
+        q->head = (q->head + 1) % cap;
+        q->count--;
+    }
+    size_t slot = (q->head + q->count) % cap;
+    std::memcpy(q->audio.data() + slot * VAD_FRAME_SAMPLES, frame,
+                VAD_FRAME_SAMPLES * sizeof(int16_t));
+    q->slots[slot] = {now, speech, backlog};
+    q->count++;
+    q->backlog += backlog;
+}
+
+// Move the oldest `n` slots into `out` as one contiguous run; returns
+// how many of them were backlog
+static size_t uplink_pop(UplinkQueue *q, size_t n, std::vector<int16_t> &out,
+                         gint64 now) {
+    size_t cap = q->slots.size();
+    size_t backlog = 0;
+    out.resize(n * VAD_FRAME_SAMPLES);
+    for (size_t i = 0; i < n; i++) {
+        size_t slot = (q->head + i) % cap;
+        if (q->slots[slot].backlog) {
+            backlog++;
+        } else {
+            q->max_age_us =
+                std::max(q->max_age_us, now - q->slots[slot].queued_us);
+        }
+        std::memcpy(out.data() + i * VAD_FRAME_SAMPLES,
+                    q->audio.data() + slot * VAD_FRAME_SAMPLES,
+                    VAD_FRAME_SAMPLES * sizeof(int16_t));
+    }
+    q->head = (q->head + n) % cap;
+    q->count -= n;
+    q->backlog -= backlog;
+    return backlog;
+}
+
+// Drop `excess` slots: non-speech oldest first, then the oldest speech.
+// Backlog is never dropped.  Survivors are compacted to the front, in
+// order.
+static void uplink_shed(UplinkQueue *q, size_t excess) {
+    size_t cap = q->slots.size();
+    size_t silent = 0;
+    for (size_t i = 0; i < q->count; i++) {
+        const UplinkSlot &slot = q->slots[(q->head + i) % cap];
+        silent += !slot.backlog && !slot.speech;
+    }
+    size_t drop_silent = std::min(excess, silent);
+    size_t drop_speech = excess - drop_silent;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < q->count; i++) {
+        size_t from = (q->head + i) % cap;
+        const UplinkSlot slot = q->slots[from];
+        bool drop = !slot.backlog &&
+                    (slot.speech ? drop_speech > 0 : drop_silent > 0);
+        if (drop) {
+            (slot.speech ? drop_speech : drop_silent)--;
+            uplink_count_drop(q, slot);
+            continue;
+        }
+        size_t to = (q->head + kept) % cap;
+        if (to != from) {
+            std::memcpy(q->audio.data() + to * VAD_FRAME_SAMPLES,
+                        q->audio.data() + from * VAD_FRAME_SAMPLES,
+                        VAD_FRAME_SAMPLES * sizeof(int16_t));
+            q->slots[to] = slot;
+        }
+        kept++;
+    }
+    q->count = kept;
+}
+
+// Audio already sent upstream, kept so it can be replayed into a new
+// session if the connection drops before the server has transcribed
+// it.  There are no acknowledgements in the protocol, so audio counts
+// as transcribed once a text delta arrives WS_ACK_DELAY_US after it was
+// sent.  Everything is kept in whole VAD frames.
+static constexpr size_t WS_RETAIN_SECONDS = 8;
+static constexpr gint64 WS_ACK_DELAY_US = 2 * G_USEC_PER_SEC;
+static constexpr size_t WS_RETAIN_MARKS = 256;  // one per frame sent
+
+struct RetentionBuffer {
+    PrerollBuffer audio;
+    uint64_t end = 0;  // samples ever retained, the position after the newest
+    std::array<std::pair<gint64, uint64_t>, WS_RETAIN_MARKS> marks{};
+    size_t mark_head = 0;  // oldest
+    size_t mark_count = 0;
+};
+
+static void retain_reset(RetentionBuffer *r) {
+    size_t frames = (WS_RETAIN_SECONDS * WS_SAMPLE_RATE + VAD_FRAME_SAMPLES - 1) /
+                    VAD_FRAME_SAMPLES;
+    preroll_reset(&r->audio, frames * VAD_FRAME_SAMPLES);
+    r->end = 0;
+    r->mark_head = 0;
+    r->mark_count = 0;
+}
+
+static void retain_push(RetentionBuffer *r, const int16_t *samples,
+                        size_t count, gint64 now) {
+    preroll_push(&r->audio, samples, count);
+    r->end += count;
+    size_t slot = (r->mark_head + r->mark_count) % WS_RETAIN_MARKS;
+    r->marks[slot] = {now, r->end};
+    if (r->mark_count < WS_RETAIN_MARKS) {
+        r->mark_count++;
+    } else {
+        r->mark_head = (r->mark_head + 1) % WS_RETAIN_MARKS;
+    }
+}
+
+// A delta arrived at `now`: forget audio sent long enough before it
+static void retain_ack(RetentionBuffer *r, gint64 now) {
+    uint64_t acked = 0;
+    while (r->mark_count > 0 &&
+           r->marks[r->mark_head].first <= now - WS_ACK_DELAY_US) {
+        acked = r->marks[r->mark_head].second;
+        r->mark_head = (r->mark_head + 1) % WS_RETAIN_MARKS;
+        r->mark_count--;
+    }
+    PrerollBuffer *p = &r->audio;
+    uint64_t oldest = r->end - p->size;
+    if (acked <= oldest) return;
+    size_t n = static_cast<size_t>(std::min<uint64_t>(acked - oldest, p->size));
+    p->start = (p->start + n) % p->buf.size();
+    p->size -= n;
+}
+
+struct VoiceNote {
+    std::string id;  // filename stem, unchanged when the note is re-encoded
+    std::string filepath;
+    std::string display_name;
+    double duration_seconds;
+    std::string transcription;
+    bool transcribing = false;
+    std::string diarized_transcription;
+    bool diarizing = false;
+};
+
+struct AppState;
+
+// Audio as sent to the batch API
+struct UploadPayload {
+    GBytes *bytes = nullptr;  // null if the note couldn't be read
+    std::string filename;
+    const char *mime_type = nullptr;
+};
+
+using UploadReady = void (*)(AppState *state, void *userdata,
+                             const UploadPayload &payload);
+
+// Batch API requests are queued and run a few at a time, see the
+// "Request scheduler" section
+enum class ApiEndpoint { TRANSCRIBE, DIARIZE };
+static constexpr size_t API_ENDPOINT_COUNT = 2;
+
+enum class ApiPriority { INTERACTIVE, BULK };  // lower runs first
+
+struct ApiJob;
+using ApiJobPrepare = void (*)(AppState *state, ApiJob *job);
+// `response` is null when the request never completed; `error` then says
+// why.  Cancelled jobs get neither, see api_job_cancelled().
+using ApiJobDone = void (*)(AppState *state, ApiJob *job, GBytes *response,
+                            const char *error);
+
+struct ApiJob {
+    AppState *state = nullptr;
+    std::string note_id;
+    ApiEndpoint endpoint = ApiEndpoint::TRANSCRIBE;
+    ApiPriority priority = ApiPriority::INTERACTIVE;
+    ApiJobPrepare prepare = nullptr;  // ends in api_job_prepared() or,
+                                      // sending nothing, api_job_complete()
+    ApiJobDone done = nullptr;
+    void *userdata = nullptr;
+    size_t part = 0;
+
+    UploadPayload payload;  // kept for retries
+    uint64_t seq = 0;
+    int attempts = 0;
+    gint64 not_before = 0;  // monotonic time, set while backing off
+    bool running = false;   // holds a slot, from prepare until done
+    GCancellable *cancellable = nullptr;
+    SoupMessage *msg = nullptr;
+};
+
+struct ApiScheduler {
+    std::vector<ApiJob *> jobs;  // queued, backing off or running
+    int running = 0;
+    int running_by_endpoint[API_ENDPOINT_COUNT] = {};
+    gint64 paused_until = 0;     // after a 429, nothing starts before this
+    guint wakeup_id = 0;
+    uint64_t next_seq = 0;
+};
+
+struct AppState {
+    GtkWidget *window = nullptr;
+    GtkWidget *label = nullptr;
+    GtkWidget *record_button = nullptr;
+    GtkWidget *level_bar = nullptr;
+
+    // Save/Discard UI
+    GtkWidget *save_discard_box = nullptr;
+    GtkWidget *save_button = nullptr;
+    GtkWidget *discard_button = nullptr;
+
+    // Notes list UI
+    GtkWidget *notes_list_box = nullptr;
+    GtkWidget *notes_scroll = nullptr;
+
+    // PulseAudio (playback and device enumeration, on the GTK main loop)
+    pa_glib_mainloop *pa_ml = nullptr;
+    pa_context *pa_ctx = nullptr;
+
+    // PulseAudio capture (dedicated thread, drained by a main loop pump)
+    pa_threaded_mainloop *capture_ml = nullptr;
+    pa_context *capture_ctx = nullptr;
+    bool capture_ready = false;
+    CaptureTap capture;       // archive tap, or the 16 kHz dictation stream
+    CaptureTap live_capture;  // 16 kHz tap for live transcription
+    guint capture_pump_id = 0;
+    std::vector<int16_t> capture_scratch;
+
+    // PulseAudio playback
+    pa_stream *playback_stream = nullptr;
+    bool playing = false;
+    AudioDecoder playback_decoder;  // decoded a request at a time
+    int playing_note_index = -1;
+
+    bool recording = false;
+    bool pa_ready = false;
+    guint level_tick_id = 0;
+
+    // Recording is streamed to a temp WAV; Save renames it into place.
+    // Captured audio collects in pooled blocks and is written out in one
+    // writev() roughly every RECORDING_FLUSH_SAMPLES.
+    WavWriter recording_file;
+    AudioChunkStore recording_pending;
+    bool recording_write_error = false;
+
+    // Notes data
+    std::vector<VoiceNote> notes;
+    std::string data_dir;
+    guint notes_refresh_id = 0;
+
+    // Transcription service
+    SoupSession *soup_session = nullptr;
+    int upload_parallelism = DEFAULT_UPLOAD_PARALLELISM;  // requests in flight
+    ApiScheduler api;
+    int connection_keepalive = DEFAULT_CONNECTION_KEEPALIVE;
+    guint keep_warm_id = 0;
+    bool network_available = true;
+    // Requests waiting on an upload payload, keyed by cache path
+    std::map<std::string, std::vector<std::pair<UploadReady, void *>>>
+        upload_waiters;
+    std::string api_key;
+    bool transcription_available = false;
+
+    // Real-time transcription (WebSocket)
+    SoupWebsocketConnection *ws_conn = nullptr;
+    bool ws_ready = false;
+    // Parked, already configured session for the next ws_connect()
+    bool realtime_standby = false;
+    SoupWebsocketConnection *ws_standby = nullptr;
+    bool ws_standby_ready = false;
+    bool ws_standby_connecting = false;
+    GCancellable *ws_standby_cancel = nullptr;  // the connect in flight
+    std::string ws_standby_key;                 // API key it was started with
+    int ws_standby_failures = 0;
+    guint ws_standby_timer_id = 0;
+    bool ws_buffering = false;     // session being set up, see ws_preroll
+    PrerollBuffer ws_preroll;
+    std::string ws_frame;          // append message, rebuilt in place
+    UplinkQueue ws_queue;          // gated audio waiting for the socket
+    std::vector<int16_t> ws_scratch;
+    size_t ws_frame_slots = 1;     // target frame size for this session
+    int ws_budget_ms = UPLINK_BUDGET_LIVE_MS;
+    int ws_socket_fd = -1;         // for SIOCOUTQ, -1 if not found
+    int ws_socket_high_water = UPLINK_SOCKET_HIGH_WATER;
+    int ws_lag_ms = 0;             // queued audio plus unsent socket bytes
+    int ws_lag_shown = 0;          // last value put on screen, tenths of s
+    // Recovery from a dropped session
+    bool ws_closing = false;       // ws_disconnect() asked for the close
+    bool ws_reconnecting = false;
+    int ws_reconnect_attempts = 0;
+    guint ws_reconnect_id = 0;
+    RetentionBuffer ws_retained;   // sent audio not yet known transcribed
+    std::string ws_recent_text;    // tail of the text delivered so far
+    bool ws_dedupe = false;        // holding deltas that may repeat it
+    std::string ws_dedupe_text;
+    guint ws_dedupe_id = 0;
+    // Rotation onto a fresh session during long recordings
+    gint64 ws_session_started_us = 0;
+    SoupWebsocketConnection *ws_successor = nullptr;
+    bool ws_successor_ready = false;
+    bool ws_successor_connecting = false;
+    gint64 ws_successor_ready_us = 0;
+    gint64 ws_successor_retry_us = 0;
+    SoupWebsocketConnection *ws_retiring = nullptr;  // draining last deltas
+    gint64 ws_retire_started_us = 0;
+    guint ws_retire_id = 0;
+    std::string ws_held_text;      // successor's text while the old drains
+    bool ws_rotate_overlapped = false;
+    int ws_rotations = 0;
+    int dictation_frame_ms = DEFAULT_DICTATION_FRAME_MS;
+    int live_frame_ms = DEFAULT_LIVE_FRAME_MS;
+    uint64_t ws_frames_sent = 0;
+    uint64_t ws_bytes_sent = 0;    // whole messages, envelope included
+    uint64_t ws_samples_sent = 0;
+    uint64_t ws_frame_allocs = 0;  // buffer regrowths, debug builds only
+    VoiceGate vad;                 // drops silence from the uplink
+    std::vector<int16_t> vad_out;
+    std::vector<uint8_t> vad_speech;
+    std::string live_transcription;
+    GtkWidget *live_transcription_scroll = nullptr;
+    GtkWidget *live_transcription_view = nullptr;
+    GtkTextMark *live_view_end = nullptr;   // kept at the end, for scrolling
+    std::string live_view_pending;          // deltas not yet on screen
+    guint live_view_tick_id = 0;
+    std::string live_transcription_tmp_path;
+    TranscriptJournal journal;     // writes live_transcription_tmp_path
+    int journal_sync_ms = DEFAULT_JOURNAL_SYNC_MS;
+    int journal_sync_bytes = DEFAULT_JOURNAL_SYNC_BYTES;
+
+    // In-process 44100→16000 fallback, used only when the 16 kHz tap
+    // can't be opened alongside the archive stream
+    bool live_resample = false;
+    Resampler live_resampler;
+    std::vector<int16_t> live_resample_buf;
+
+    // Dictation mode
+    bool dictating = false;
+    TypingWorker typer;
+    TypingTool typing_tool = TypingTool::NONE;  // cached probe result
+    std::map<TypingTool, gint64> typing_excluded;  // failed on real text, when
+    bool typing_probing = false;
+    bool typing_probe_valid = false;
+    gint64 typing_probe_time = 0;  // monotonic, when the probe started
+    std::vector<TypingProbeResult> typing_probe_results;
+    GtkWidget *typing_status_label = nullptr;  // while Settings is open
+    std::string dictation_buffer;
+    guint dictation_flush_id = 0;
+    AppIndicator *indicator = nullptr;
+    std::string hotkey;
+    GtkWidget *dictation_menu_item = nullptr;
+    GtkWidget *transcribe_all_menu_item = nullptr;
+
+    // Audio device selection
+    std::vector<std::pair<std::string, std::string>> audio_sources;  // (pa_name, description)
+    std::string audio_device;  // selected device pa_name, empty = default
+    const CodecInfo *archive_codec = &AUDIO_CODECS[0];  // format for new notes
+};
+
+// Forward declarations
+static void stop_playback(AppState *state);
+static void refresh_notes_list(AppState *state);
+static void load_notes(AppState *state);
+static void transcribe_note(AppState *state, int note_index,
+                            ApiPriority priority);
+static void ws_connect(AppState *state);
+static void ws_session_ready(AppState *state);
+static void ws_session_lost(AppState *state);
+static bool ws_retry_connect(AppState *state);
+static void ws_receive_text(AppState *state, const char *text);
+static void ws_dedupe_finish(AppState *state);
+static void ws_rotate_tick(AppState *state);
+static void ws_rotate_stop(AppState *state);
+static void ws_disconnect(AppState *state);
+static void standby_open(AppState *state);
+static void ws_send_audio(AppState *state, const int16_t *samples, size_t count);
+static void ws_queue_audio(AppState *state, const int16_t *samples,
+                           size_t count, bool backlog);
+static void start_dictation(AppState *state);
+static void stop_dictation(AppState *state);
+static void update_dictation_menu_label(AppState *state);
+static void type_text(AppState *state, const char *text);
+static void diarize_note(AppState *state, int note_index,
+                         ApiPriority priority);
+
+// --- Storage helpers ---
+
+static void ensure_data_dir(AppState *state) {
+    const char *data_base = g_get_user_data_dir();
+    state->data_dir = std::string(data_base) + "/linscribe";
+    std::filesystem::create_directories(state->data_dir);
+}
+
+static std::string generate_note_filename(const std::string &data_dir) {
+    std::time_t now = std::time(nullptr);
+    std::tm *tm = std::localtime(&now);
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "note_%Y-%m-%d_%H-%M-%S.wav", tm);
+    return data_dir + "/" + buf;
+}
+
+static void load_notes(AppState *state) {
+    state->notes.clear();
+
+    if (!std::filesystem::exists(state->data_dir)) return;
+
+    for (const auto &entry :
+         std::filesystem::directory_iterator(state->data_dir)) {
+        if (!entry.is_regular_file()) continue;
+        if (codec_for_path(entry.path()) == nullptr) continue;
+        if (entry.path().stem().extension() == ".upload") continue;
+
+        VoiceNote note;
+        note.filepath = entry.path().string();
+        // Extract display name from filename: note_YYYY-MM-DD_HH-MM-SS.<ext>
+        std::string stem = entry.path().stem().string();
+        note.id = stem;
+        if (stem.rfind("note_", 0) == 0 && stem.size() >= 24) {
+            // Convert note_YYYY-MM-DD_HH-MM-SS to YYYY-MM-DD HH:MM:SS
+            std::string date_part = stem.substr(5, 10);       // YYYY-MM-DD
+            std::string time_part = stem.substr(16, 8);       // HH-MM-SS
+            // Replace dashes with colons in time
+            for (auto &c : time_part) {
+                if (c == '-') c = ':';
+            }
+            note.display_name = date_part + " " + time_part;
+        } else {
+            note.display_name = stem;
+        }
+        note.duration_seconds = get_audio_duration(note.filepath);
+
+        // Load transcription from .txt sidecar if it exists
+        std::filesystem::path txt_path = entry.path();
+        txt_path.replace_extension(".txt");
+        if (std::filesystem::exists(txt_path)) {
+            std::ifstream txt_file(txt_path);
+            if (txt_file) {
+                note.transcription = std::string(
+                    std::istreambuf_iterator<char>(txt_file),
+                    std::istreambuf_iterator<char>());
+            }
+        }
+
+        // Load diarized transcription from .diarized.txt sidecar if it exists
+        std::filesystem::path diarized_path(note.filepath);
+        diarized_path.replace_extension(".diarized.txt");
+        if (std::filesystem::exists(diarized_path)) {
+            std::ifstream diarized_file(diarized_path);
+            if (diarized_file) {
+                note.diarized_transcription = std::string(
+                    std::istreambuf_iterator<char>(diarized_file),
+                    std::istreambuf_iterator<char>());
+            }
+        }
+
+        state->notes.push_back(std::move(note));
+    }
+
+    // Sort newest-first
+    std::sort(state->notes.begin(), state->notes.end(),
+              [](const VoiceNote &a, const VoiceNote &b) {
+                  return a.filepath > b.filepath;
+              });
+
+    // Keep the spinners of notes with requests still queued or running
+    for (const ApiJob *job : state->api.jobs) {
+        for (VoiceNote &note : state->notes) {
+            if (note.id != job->note_id) continue;
+            if (job->endpoint == ApiEndpoint::TRANSCRIBE) {
+                note.transcribing = true;
+            } else {
+                note.diarizing = true;
+            }
+        }
+    }
+}
+
+static std::string note_id_for_path(const std::string &path) {
+    return std::filesystem::path(path).stem().string();
+}
+
+static int find_note(AppState *state, const std::string &id) {
+    for (size_t i = 0; i < state->notes.size(); i++) {
+        if (state->notes[i].id == id) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// --- Background encoding ---
+
+struct EncodeJob {
+    AppState *state;
+    std::string src;
+    std::string dst;
+    const CodecInfo *codec;
+};
+
+// Encodes into `dst`.encoding; the result is put in place on the main
+// thread, where notes are deleted
+static void encode_note_thread(GTask *task, gpointer /*source*/,
+                               gpointer task_data,
+                               GCancellable * /*cancellable*/) {
+    auto *job = static_cast<EncodeJob *>(task_data);
+    bool ok = encode_audio_file(job->src, job->dst + ".encoding", job->codec, 0);
+    g_task_return_boolean(task, ok);
+}
+
+static void on_note_encoded(GObject * /*source*/, GAsyncResult *result,
+                            gpointer /*userdata*/) {
+    auto *job = static_cast<EncodeJob *>(
+        g_task_get_task_data(G_TASK(result)));
+    std::string tmp = job->dst + ".encoding";
+    std::error_code ec;
+    bool ok = g_task_propagate_boolean(G_TASK(result), nullptr);
+
+    // The note may have been deleted while it was being encoded
+    bool deleted = !std::filesystem::exists(job->src);
+    if (ok && !deleted) {
+        std::filesystem::rename(tmp, job->dst, ec);
+        ok = !ec;
+    }
+    if (!ok || deleted) {
+        std::filesystem::remove(tmp, ec);
+        if (!deleted) {
+            g_warning("Failed to encode %s as %s — keeping WAV",
+                      job->src.c_str(), job->codec->key);
+        }
+        return;
+    }
+    std::filesystem::remove(job->src, ec);
+
+    // Same stem, so the note keeps its place in the sorted list
+    load_notes(job->state);
+    refresh_notes_list(job->state);
+}
+
+// Replace the WAV at `wav_path` with the configured archive format
+static void encode_note_async(AppState *state, const std::string &wav_path) {
+    const CodecInfo *codec = state->archive_codec;
+    if (codec->codec == AudioCodec::WAV) return;
+
+    std::filesystem::path dst(wav_path);
+    dst.replace_extension(codec->extension);
+    auto *job = new EncodeJob{state, wav_path, dst.string(), codec};
+
+    GTask *task = g_task_new(nullptr, nullptr, on_note_encoded, nullptr);
+    g_task_set_task_data(task, job, [](gpointer data) {
+        delete static_cast<EncodeJob *>(data);
+    });
+    g_task_run_in_thread(task, encode_note_thread);
+    g_object_unref(task);
+}
+
+// --- Upload preparation ---
+
+// The batch API works on 16 kHz mono, so notes are downsampled and FLAC
+// compressed before upload, which is about a tenth of the 44.1 kHz WAV.
+// The result is cached next to the note as note_*.upload.flac and shared
+// by transcribe and diarize.
+
+static constexpr uint32_t UPLOAD_SAMPLE_RATE = WS_SAMPLE_RATE;
+static constexpr AudioCodec UPLOAD_CODEC = AudioCodec::FLAC;
+
+static std::string upload_cache_path(const std::string &note_path) {
+    std::filesystem::path p(note_path);
+    p.replace_extension(std::string(".upload") +
+                        codec_info(UPLOAD_CODEC)->extension);
+    return p.string();
+}
+
+static UploadPayload map_upload_payload(const std::string &path,
+                                        const char *mime_type,
+                                        const std::string &filename) {
+    UploadPayload payload;
+    GError *error = nullptr;
+    GMappedFile *mapped = g_mapped_file_new(path.c_str(), FALSE, &error);
+    if (mapped == nullptr) {
+        if (error) {
+            g_warning("File read error: %s", error->message);
+            g_error_free(error);
+        }
+        return payload;
+    }
+    payload.bytes = g_mapped_file_get_bytes(mapped);
+    g_mapped_file_unref(mapped);
+    payload.filename = filename;
+    payload.mime_type = mime_type;
+    return payload;
+}
+
+// The prepared payload if there is one, else the note file itself
+static UploadPayload load_upload_payload(const std::string &note_path) {
+    std::filesystem::path fp(note_path);
+    std::string cache = upload_cache_path(note_path);
+    if (std::filesystem::exists(cache)) {
+        const CodecInfo *codec = codec_info(UPLOAD_CODEC);
+        UploadPayload payload = map_upload_payload(
+            cache, codec->mime_type, fp.stem().string() + codec->extension);
+        if (payload.bytes != nullptr) return payload;
+    }
+    const CodecInfo *codec = codec_for_path(fp);
+    return map_upload_payload(note_path,
+                              codec != nullptr ? codec->mime_type
+                                               : "audio/wav",
+                              fp.filename().string());
+}
+
+struct PrepareJob {
+    AppState *state;
+    std::string src;
+    std::string cache;
+};
+
+static void prepare_upload_thread(GTask *task, gpointer /*source*/,
+                                  gpointer task_data,
+                                  GCancellable * /*cancellable*/) {
+    auto *job = static_cast<PrepareJob *>(task_data);
+    std::string tmp = job->cache + ".encoding";
+    bool ok = encode_audio_file(job->src, tmp, codec_info(UPLOAD_CODEC),
+                                UPLOAD_SAMPLE_RATE);
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmp, job->cache, ec);
+        ok = !ec;
+    }
+    if (!ok) std::filesystem::remove(tmp, ec);
+    g_task_return_boolean(task, ok);
+}
+
+static void on_upload_prepared(GObject * /*source*/, GAsyncResult *result,
+                               gpointer /*userdata*/) {
+    auto *job = static_cast<PrepareJob *>(
+        g_task_get_task_data(G_TASK(result)));
+    AppState *state = job->state;
+    if (!g_task_propagate_boolean(G_TASK(result), nullptr)) {
+        g_warning("Could not prepare %s for upload — sending it as is",
+                  job->src.c_str());
+    }
+
+    // The note may have been re-encoded or deleted in the meantime.  A
+    // delete removes the cache before this job renames it into place, so
+    // take it away again rather than leave it with no note.
+    int note_index = find_note(state, note_id_for_path(job->src));
+    if (note_index < 0) {
+        std::error_code ec;
+        std::filesystem::remove(job->cache, ec);
+    }
+
+    auto it = state->upload_waiters.find(job->cache);
+    if (it == state->upload_waiters.end()) return;
+    auto waiters = std::move(it->second);
+    state->upload_waiters.erase(it);
+
+    UploadPayload payload;
+    if (note_index >= 0) {
+        payload = load_upload_payload(
+            state->notes[static_cast<size_t>(note_index)].filepath);
+    }
+    for (const auto &[ready, userdata] : waiters) {
+        ready(state, userdata, payload);
+    }
+    if (payload.bytes != nullptr) g_bytes_unref(payload.bytes);
+}
+
+// Call `ready` with the note's upload payload, preparing it first if needed
+static void request_upload(AppState *state, int note_index,
+                           UploadReady ready, void *userdata) {
+    const VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
+    std::string cache = upload_cache_path(note.filepath);
+
+    if (std::filesystem::exists(cache)) {
+        UploadPayload payload = load_upload_payload(note.filepath);
+        ready(state, userdata, payload);
+        if (payload.bytes != nullptr) g_bytes_unref(payload.bytes);
+        return;
+    }
+
+    auto &waiters = state->upload_waiters[cache];
+    waiters.emplace_back(ready, userdata);
+    if (waiters.size() > 1) return;  // already being prepared
+
+    auto *job = new PrepareJob{state, note.filepath, cache};
+    GTask *task = g_task_new(nullptr, nullptr, on_upload_prepared, nullptr);
+    g_task_set_task_data(task, job, [](gpointer data) {
+        delete static_cast<PrepareJob *>(data);
+    });
+    g_task_run_in_thread(task, prepare_upload_thread);
+    g_object_unref(task);
+}
+
+// --- Connection warm-up ---
+
+// A cold request pays for DNS, TCP and TLS before its first byte, which
+// is most noticeable when starting dictation.  An idle connection to the
+// API host is opened at startup and whenever the network comes back.
+// Every `connection_keepalive` seconds an authenticated HEAD request goes
+// over it; merely preconnecting would be a no-op while a connection is
+// idle and wouldn't restart its idle timer, so it would expire between
+// refreshes.
+
+static constexpr const char *API_WARMUP_URL = "https://api.mistral.ai/v1/models";
+static constexpr guint CONNECTION_IDLE_MARGIN_SECONDS = 15;
+static constexpr guint SESSION_IDLE_TIMEOUT_SECONDS = 60;  // libsoup's default
+
+static double metrics_span_ms(guint64 start, guint64 end) {
+    if (start == 0 || end < start) return 0.0;
+    return static_cast<double>(end - start) / 1000.0;
+}
+
+// Log where connection setup time went, if `msg` needed a new connection
+static void log_connection_metrics(const char *what, SoupMessage *msg) {
+    SoupMessageMetrics *m = soup_message_get_metrics(msg);
+    if (m == nullptr) return;
+    guint64 connect_start = soup_message_metrics_get_connect_start(m);
+    if (connect_start == 0) return;  // reused an open connection
+
+    guint64 connect_end = soup_message_metrics_get_connect_end(m);
+    guint64 tls_start = soup_message_metrics_get_tls_start(m);
+    g_message("%s: new connection, dns %.0f ms, tcp %.0f ms, tls %.0f ms",
+              what,
+              metrics_span_ms(soup_message_metrics_get_dns_start(m),
+                              soup_message_metrics_get_dns_end(m)),
+              metrics_span_ms(connect_start,
+                              tls_start != 0 ? tls_start : connect_end),
+              metrics_span_ms(tls_start, connect_end));
+}
+
+static void on_warmup_done(GObject *source, GAsyncResult *result,
+                           gpointer userdata) {
+    auto *msg = SOUP_MESSAGE(userdata);
+    GError *error = nullptr;
+    GBytes *body = soup_session_send_and_read_finish(SOUP_SESSION(source),
+                                                     result, &error);
+    if (body != nullptr) {
+        log_connection_metrics("Warm-up", msg);
+        g_bytes_unref(body);
+    } else {
+        g_message("Connection warm-up failed: %s", error->message);
+        g_error_free(error);
+    }
+    g_object_unref(msg);
+}
+
+// Use the idle connection to the API host, opening one if there is none.
+// A HEAD request has no body either way, and resets the idle timer.
+static void warm_connections(AppState *state) {
+    if (state->soup_session == nullptr || !state->transcription_available)
+        return;
+    if (!g_network_monitor_get_network_available(
+            g_network_monitor_get_default()))
+        return;
+
+    SoupMessage *msg = soup_message_new("HEAD", API_WARMUP_URL);
+    soup_message_add_flags(msg, SOUP_MESSAGE_COLLECT_METRICS);
+    std::string auth = "Bearer " + state->api_key;
+    soup_message_headers_replace(soup_message_get_request_headers(msg),
+                                 "Authorization", auth.c_str());
+    soup_session_send_and_read_async(state->soup_session, msg, G_PRIORITY_LOW,
+                                     nullptr, on_warmup_done, msg);
+}
+
+static gboolean on_keep_warm(gpointer userdata) {
+    warm_connections(static_cast<AppState *>(userdata));
+    return G_SOURCE_CONTINUE;
+}
+
+// Apply `connection_keepalive` to the session and (re)start the refresh
+static void configure_connection_warmup(AppState *state) {
+    if (state->keep_warm_id != 0) {
+        g_source_remove(state->keep_warm_id);
+        state->keep_warm_id = 0;
+    }
+    if (state->soup_session == nullptr) return;
+
+    if (state->connection_keepalive > 0) {
+        // Each refresh restarts the idle timer, so outliving the interval
+        // keeps the connection open between refreshes
+        auto keepalive = static_cast<guint>(state->connection_keepalive);
+        soup_session_set_idle_timeout(
+            state->soup_session, keepalive + CONNECTION_IDLE_MARGIN_SECONDS);
+        state->keep_warm_id =
+            g_timeout_add_seconds(keepalive, on_keep_warm, state);
+    } else {
+        soup_session_set_idle_timeout(state->soup_session,
+                                      SESSION_IDLE_TIMEOUT_SECONDS);
+    }
+    warm_connections(state);
+}
+
+static void on_network_changed(GNetworkMonitor * /*monitor*/,
+                               gboolean available, gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    bool was_available = state->network_available;
+    state->network_available = available;
+    if (available && !was_available) {
+        g_message("Network is back — warming connections");
+        warm_connections(state);
+        standby_open(state);
+    }
+}
+
+// --- Request scheduler ---
+
+// Every batch API request goes through one queue.  At most
+// `upload_parallelism` run at once, and fewer per endpoint where the
+// service is slower.  Interactive requests start before bulk ones.
+// Failed requests are retried with exponential backoff, and a 429 pauses
+// the whole queue for as long as the server asks.  Jobs refer to notes by
+// ID, so reloading the list never sends a result to the wrong note.
+
+struct ApiEndpointInfo {
+    const char *name;
+    int max_in_flight;
+};
+
+static const ApiEndpointInfo API_ENDPOINTS[API_ENDPOINT_COUNT] = {
+    {"transcribe", MAX_UPLOAD_PARALLELISM},  // bounded by the global cap
+    {"diarize", 2},
+};
+
+static constexpr const char *API_TRANSCRIPTIONS_URL =
+    "https://api.mistral.ai/v1/audio/transcriptions";
+static constexpr int API_MAX_ATTEMPTS = 5;
+static constexpr gint64 API_BACKOFF_BASE_US = 2 * G_USEC_PER_SEC;
+static constexpr gint64 API_BACKOFF_MAX_US = 120 * G_USEC_PER_SEC;
+static constexpr gint64 API_RETRY_AFTER_MAX_US = 600 * G_USEC_PER_SEC;
+
+static void api_schedule(AppState *state);
+
+static size_t endpoint_index(ApiEndpoint endpoint) {
+    return static_cast<size_t>(endpoint);
+}
+
+static ApiJob *api_job_new(AppState *state, ApiEndpoint endpoint,
+                           ApiPriority priority, const std::string &note_id) {
+    auto *job = new ApiJob{};
+    job->state = state;
+    job->endpoint = endpoint;
+    job->priority = priority;
+    job->note_id = note_id;
+    return job;
+}
+
+static void api_job_free(ApiJob *job) {
+    if (job->payload.bytes != nullptr) g_bytes_unref(job->payload.bytes);
+    g_clear_object(&job->msg);
+    g_clear_object(&job->cancellable);
+    delete job;
+}
+
+static bool api_job_cancelled(const ApiJob *job) {
+    return g_cancellable_is_cancelled(job->cancellable);
+}
+
+static void api_release_slot(AppState *state, ApiJob *job) {
+    if (!job->running) return;
+    job->running = false;
+    state->api.running--;
+    state->api.running_by_endpoint[endpoint_index(job->endpoint)]--;
+}
+
+// Remove the job from the queue and report its outcome
+static void api_job_complete(AppState *state, ApiJob *job, GBytes *response,
+                             const char *error) {
+    auto &jobs = state->api.jobs;
+    jobs.erase(std::remove(jobs.begin(), jobs.end(), job), jobs.end());
+    api_release_slot(state, job);
+    job->done(state, job, response, error);
+    api_job_free(job);
+    api_schedule(state);
+}
+
+static void api_submit(AppState *state, ApiJob *job) {
+    job->seq = state->api.next_seq++;
+    job->cancellable = g_cancellable_new();
+    state->api.jobs.push_back(job);
+    api_schedule(state);
+}
+
+// Cancel queued and running jobs matching `pred`.  Jobs that are not
+// running finish here; running ones finish when their request returns.
+template <typename Pred>
+static void api_cancel_where(AppState *state, Pred pred) {
+    for (ApiJob *job : state->api.jobs) {
+        if (pred(job)) g_cancellable_cancel(job->cancellable);
+    }
+    for (;;) {
+        auto &jobs = state->api.jobs;
+        auto it = std::find_if(jobs.begin(), jobs.end(), [](ApiJob *job) {
+            return !job->running && api_job_cancelled(job);
+        });
+        if (it == jobs.end()) break;
+        api_job_complete(state, *it, nullptr, nullptr);
+    }
+}
+
+static void api_cancel_note(AppState *state, const std::string &note_id) {
+    api_cancel_where(state, [&](ApiJob *job) {
+        return job->note_id == note_id;
+    });
+}
+
+static void api_cancel_group(AppState *state, const void *userdata) {
+    api_cancel_where(state, [&](ApiJob *job) {
+        return job->userdata == userdata;
+    });
+}
+
+static void api_cancel_all(AppState *state) {
+    api_cancel_where(state, [](ApiJob *) { return true; });
+}
+
+static size_t api_pending_count(AppState *state, ApiEndpoint endpoint) {
+    return static_cast<size_t>(std::count_if(
+        state->api.jobs.begin(), state->api.jobs.end(),
+        [&](const ApiJob *job) { return job->endpoint == endpoint; }));
+}
+
+static void on_api_response(GObject *source, GAsyncResult *result,
+                            gpointer userdata);
+
+static void api_send(AppState *state, ApiJob *job) {
+    if (state->soup_session == nullptr) {
+        api_job_complete(state, job, nullptr, "no API key");
+        return;
+    }
+
+    SoupMultipart *multipart = soup_multipart_new(SOUP_FORM_MIME_TYPE_MULTIPART);
+    soup_multipart_append_form_string(multipart, "model", "voxtral-mini-latest");
+    if (job->endpoint == ApiEndpoint::DIARIZE) {
+        soup_multipart_append_form_string(multipart, "diarize", "true");
+        soup_multipart_append_form_string(multipart, "timestamp_granularities",
+                                           "segment");
+    }
+    soup_multipart_append_form_file(multipart, "file",
+                                     job->payload.filename.c_str(),
+                                     job->payload.mime_type,
+                                     job->payload.bytes);
+
+    job->msg = soup_message_new_from_multipart(API_TRANSCRIPTIONS_URL,
+                                               multipart);
+    soup_multipart_free(multipart);
+    soup_message_add_flags(job->msg, SOUP_MESSAGE_COLLECT_METRICS);
+
+    SoupMessageHeaders *headers = soup_message_get_request_headers(job->msg);
+    std::string auth = "Bearer " + state->api_key;
+    soup_message_headers_replace(headers, "Authorization", auth.c_str());
+
+    job->attempts++;
+    soup_session_send_and_read_async(state->soup_session, job->msg,
+                                      G_PRIORITY_DEFAULT, job->cancellable,
+                                      on_api_response, job);
+}
+
+// Called by the job's prepare step once its audio is ready
+static void api_job_prepared(AppState *state, ApiJob *job,
+                             const UploadPayload &payload) {
+    if (api_job_cancelled(job)) {
+        api_job_complete(state, job, nullptr, nullptr);
+        return;
+    }
+    if (payload.bytes == nullptr) {
+        api_job_complete(state, job, nullptr, "could not read audio file");
+        return;
+    }
+    job->payload = payload;
+    g_bytes_ref(job->payload.bytes);
+    api_send(state, job);
+}
+
+// Delay requested by a Retry-After header, in seconds or as an HTTP date
+static gint64 parse_retry_after(SoupMessage *msg) {
+    const char *value = soup_message_headers_get_one(
+        soup_message_get_response_headers(msg), "Retry-After");
+    if (value == nullptr) return -1;
+
+    char *end = nullptr;
+    gint64 seconds = g_ascii_strtoll(value, &end, 10);
+    if (end != value && *end == '\0') {
+        return std::max<gint64>(0, seconds) * G_USEC_PER_SEC;
+    }
+
+    GDateTime *date = soup_date_time_new_from_http_string(value);
+    if (date == nullptr) return -1;
+    gint64 delta = g_date_time_to_unix(date) -
+                   g_get_real_time() / G_USEC_PER_SEC;
+    g_date_time_unref(date);
+    return std::max<gint64>(0, delta) * G_USEC_PER_SEC;
+}
+
+static void api_job_retry(AppState *state, ApiJob *job, guint status,
+                          gint64 retry_after) {
+    api_release_slot(state, job);
+    g_clear_object(&job->msg);
+
+    gint64 delay;
+    if (retry_after >= 0) {
+        delay = std::min(retry_after, API_RETRY_AFTER_MAX_US);
+    } else {
+        // Exponential, with jitter so parallel failures don't retry together
+        gint64 backoff = std::min(API_BACKOFF_MAX_US,
+                                  API_BACKOFF_BASE_US << (job->attempts - 1));
+        delay = backoff / 2 +
+                static_cast<gint64>(g_random_double_range(0.0, backoff / 2.0));
+    }
+    gint64 now = g_get_monotonic_time();
+    job->not_before = now + delay;
+
+    if (status == SOUP_STATUS_TOO_MANY_REQUESTS) {
+        // Rate limits are per key, so hold every request back
+        state->api.paused_until = std::max(state->api.paused_until,
+                                           job->not_before);
+        char buf[96];
+        g_snprintf(buf, sizeof(buf), "Rate limited — retrying in %d s",
+                   static_cast<int>((delay + G_USEC_PER_SEC - 1) /
+                                    G_USEC_PER_SEC));
+        gtk_label_set_text(GTK_LABEL(state->label), buf);
+    }
+    api_schedule(state);
+}
+
+static void on_api_response(GObject *source, GAsyncResult *result,
+                            gpointer userdata) {
+    auto *job = static_cast<ApiJob *>(userdata);
+    AppState *state = job->state;
+
+    GError *error = nullptr;
+    GBytes *response_bytes = soup_session_send_and_read_finish(
+        SOUP_SESSION(source), result, &error);
+    guint status = soup_message_get_status(job->msg);
+    log_connection_metrics(API_ENDPOINTS[endpoint_index(job->endpoint)].name,
+                           job->msg);
+
+    if (api_job_cancelled(job)) {
+        if (response_bytes) g_bytes_unref(response_bytes);
+        if (error) g_error_free(error);
+        api_job_complete(state, job, nullptr, nullptr);
+        return;
+    }
+
+    bool transient = error != nullptr || status == 408 ||
+                     status == SOUP_STATUS_TOO_MANY_REQUESTS ||
+                     SOUP_STATUS_IS_SERVER_ERROR(status);
+    if (transient) {
+        g_warning("%s request for %s failed (attempt %d): %s",
+                  API_ENDPOINTS[endpoint_index(job->endpoint)].name,
+                  job->note_id.c_str(), job->attempts,
+                  error != nullptr ? error->message : "server error");
+    }
+    if (transient && job->attempts < API_MAX_ATTEMPTS) {
+        gint64 retry_after = status == SOUP_STATUS_TOO_MANY_REQUESTS
+                                 ? parse_retry_after(job->msg)
+                                 : -1;
+        if (response_bytes) g_bytes_unref(response_bytes);
+        if (error) g_error_free(error);
+        api_job_retry(state, job, status, retry_after);
+        return;
+    }
+
+    if (error != nullptr) {
+        api_job_complete(state, job, nullptr, "network error");
+        g_error_free(error);
+    } else {
+        api_job_complete(state, job, response_bytes, nullptr);
+    }
+    if (response_bytes) g_bytes_unref(response_bytes);
+}
+
+static gboolean on_api_wakeup(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    state->api.wakeup_id = 0;
+    api_schedule(state);
+    return G_SOURCE_REMOVE;
+}
+
+static void api_job_start(AppState *state, ApiJob *job) {
+    job->running = true;
+    state->api.running++;
+    state->api.running_by_endpoint[endpoint_index(job->endpoint)]++;
+
+    if (job->payload.bytes != nullptr) {
+        api_send(state, job);  // a retry, the audio is already prepared
+    } else {
+        job->prepare(state, job);
+    }
+}
+
+// Start the best eligible jobs while there are free slots, and arrange to
+// be called again when a backed-off job becomes eligible
+static void api_schedule(AppState *state) {
+    ApiScheduler &api = state->api;
+    int limit = std::max(1, state->upload_parallelism);
+    gint64 wake = 0;
+
+    while (api.running < limit) {
+        gint64 now = g_get_monotonic_time();
+        wake = 0;
+        ApiJob *best = nullptr;
+        for (ApiJob *job : api.jobs) {
+            // Cancelled jobs are being completed by api_cancel_where()
+            if (job->running || api_job_cancelled(job)) continue;
+            gint64 ready = std::max(job->not_before, api.paused_until);
+            if (ready > now) {
+                if (wake == 0 || ready < wake) wake = ready;
+                continue;
+            }
+            size_t e = endpoint_index(job->endpoint);
+            if (api.running_by_endpoint[e] >= API_ENDPOINTS[e].max_in_flight)
+                continue;
+            if (best == nullptr || job->priority < best->priority ||
+                (job->priority == best->priority && job->seq < best->seq)) {
+                best = job;
+            }
+        }
+        if (best == nullptr) break;
+        api_job_start(state, best);
+    }
+
+    if (api.wakeup_id != 0) {
+        g_source_remove(api.wakeup_id);
+        api.wakeup_id = 0;
+    }
+    if (wake != 0) {
+        gint64 wait_ms = (wake - g_get_monotonic_time()) / 1000 + 1;
+        api.wakeup_id = g_timeout_add(
+            static_cast<guint>(std::max<gint64>(1, wait_ms)), on_api_wakeup,
+            state);
+    }
+}
+
+static void on_note_payload_ready(AppState *state, void *userdata,
+                                  const UploadPayload &payload) {
+    api_job_prepared(state, static_cast<ApiJob *>(userdata), payload);
+}
+
+// Prepare step for jobs that upload a whole note
+static void api_prepare_note(AppState *state, ApiJob *job) {
+    int note_index = find_note(state, job->note_id);
+    if (note_index < 0) {
+        api_job_prepared(state, job, UploadPayload{});
+        return;
+    }
+    request_upload(state, note_index, on_note_payload_ready, job);
+}
+
+// --- PulseAudio playback ---
+
+static void on_playback_drain_complete(pa_stream * /*s*/, int /*success*/,
+                                       void *userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    stop_playback(state);
+}
+
+static void on_playback_write(pa_stream *s, size_t nbytes, void *userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+
+    // Decode straight into PulseAudio's own buffer, only as much as it asks for
+    void *dest = nullptr;
+    size_t dest_bytes = nbytes;
+    if (pa_stream_begin_write(s, &dest, &dest_bytes) < 0 || dest == nullptr)
+        return;
+
+    size_t frames = audio_decoder_read(&state->playback_decoder,
+                                       static_cast<int16_t *>(dest),
+                                       dest_bytes / sizeof(int16_t));
+    if (frames == 0) {
+        pa_stream_cancel_write(s);
+        pa_stream_set_write_callback(s, nullptr, nullptr);
+        pa_operation *op = pa_stream_drain(s, on_playback_drain_complete, state);
+        if (op != nullptr) pa_operation_unref(op);
+        return;
+    }
+    pa_stream_write(s, dest, frames * sizeof(int16_t), nullptr, 0,
+                    PA_SEEK_RELATIVE);
+}
+
+static void on_playback_stream_state(pa_stream *s, void *userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    if (pa_stream_get_state(s) == PA_STREAM_FAILED) {
+        g_warning("Playback stream failed: %s",
+                  pa_strerror(pa_context_errno(state->pa_ctx)));
+        stop_playback(state);
+    }
+}
+
+static void start_playback(AppState *state, int note_index) {
+    if (note_index < 0 ||
+        note_index >= static_cast<int>(state->notes.size()))
+        return;
+    if (!state->pa_ready) return;
+
+    // Stop any current playback
+    if (state->playing) {
+        stop_playback(state);
+    }
+
+    const VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
+    if (!audio_decoder_open(&state->playback_decoder, note.filepath)) {
+        gtk_label_set_text(GTK_LABEL(state->label), "Failed to read audio file");
+        return;
+    }
+
+    const pa_sample_spec spec = {
+        .format = PA_SAMPLE_S16LE,
+        .rate = static_cast<uint32_t>(state->playback_decoder.info.samplerate),
         .channels = NUM_CHANNELS,
     };
 
-    state->playback_stream =
-        pa_stream_new(state->pa_ctx, "linscribe-playback", &spec, nullptr);
-    if (state->playback_stream == nullptr) {
-        gtk_label_set_text(GTK_LABEL(state->label),
-                           "Failed to create playback stream");
+    state->playback_stream =
+        pa_stream_new(state->pa_ctx, "linscribe-playback", &spec, nullptr);
+    if (state->playback_stream == nullptr) {
+        gtk_label_set_text(GTK_LABEL(state->label),
+                           "Failed to create playback stream");
+        audio_decoder_close(&state->playback_decoder);
+        return;
+    }
+
+    pa_stream_set_write_callback(state->playback_stream,
+                                 on_playback_write, state);
+    pa_stream_set_state_callback(state->playback_stream,
+                                 on_playback_stream_state, state);
+
+    if (pa_stream_connect_playback(state->playback_stream, nullptr, nullptr,
+                                   PA_STREAM_NOFLAGS, nullptr, nullptr) < 0) {
+        gtk_label_set_text(GTK_LABEL(state->label),
+                           "Failed to connect playback");
+        pa_stream_unref(state->playback_stream);
+        state->playback_stream = nullptr;
+        audio_decoder_close(&state->playback_decoder);
+        return;
+    }
+
+    state->playing = true;
+    state->playing_note_index = note_index;
+
+    char buf[128];
+    g_snprintf(buf, sizeof(buf), "Playing: %s", note.display_name.c_str());
+    gtk_label_set_text(GTK_LABEL(state->label), buf);
+
+    refresh_notes_list(state);
+}
+
+static void stop_playback(AppState *state) {
+    if (state->playback_stream != nullptr) {
+        pa_stream_disconnect(state->playback_stream);
+        pa_stream_unref(state->playback_stream);
+        state->playback_stream = nullptr;
+    }
+
+    bool was_playing = state->playing;
+    state->playing = false;
+    state->playing_note_index = -1;
+    audio_decoder_close(&state->playback_decoder);
+
+    if (was_playing) {
+        gtk_label_set_text(GTK_LABEL(state->label), "Ready");
+        refresh_notes_list(state);
+    }
+}
+
+// --- Live transcript view ---
+
+// Deltas are queued and put on screen once per frame, inserted at the
+// end of the buffer rather than replacing its text, so the cost of a
+// delta doesn't grow with the transcript.  The view keeps only the last
+// LIVE_VIEW_MAX_CHARS; older text is dropped from the buffer (the full
+// transcript stays in live_transcription) in LIVE_VIEW_TRIM_CHARS steps
+// so re-layout after a trim is rare.
+
+static constexpr int LIVE_VIEW_MAX_CHARS = 24000;
+static constexpr int LIVE_VIEW_TRIM_CHARS = 6000;
+
+static GtkTextBuffer *live_view_buffer(AppState *state) {
+    return gtk_text_view_get_buffer(
+        GTK_TEXT_VIEW(state->live_transcription_view));
+}
+
+// Drop the oldest text once the buffer is over its cap, at a word
+static void live_view_trim(GtkTextBuffer *buf) {
+    int count = gtk_text_buffer_get_char_count(buf);
+    if (count <= LIVE_VIEW_MAX_CHARS) return;
+
+    GtkTextIter start, cut;
+    gtk_text_buffer_get_start_iter(buf, &start);
+    gtk_text_buffer_get_iter_at_offset(
+        buf, &cut, count - LIVE_VIEW_MAX_CHARS + LIVE_VIEW_TRIM_CHARS);
+    if (!gtk_text_iter_starts_word(&cut)) {
+        gtk_text_iter_forward_word_end(&cut);
+    }
+    gtk_text_buffer_delete(buf, &start, &cut);
+}
+
+static gboolean on_live_view_tick(GtkWidget *widget, GdkFrameClock * /*clock*/,
+                                  gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    state->live_view_tick_id = 0;
+    if (state->live_view_pending.empty()) return G_SOURCE_REMOVE;
+
+    GtkTextBuffer *buf = live_view_buffer(state);
+    GtkTextIter end;
+    gtk_text_buffer_get_end_iter(buf, &end);
+    gtk_text_buffer_insert(buf, &end, state->live_view_pending.data(),
+                           static_cast<gint>(state->live_view_pending.size()));
+    state->live_view_pending.clear();
+    live_view_trim(buf);
+    gtk_text_view_scroll_mark_onscreen(GTK_TEXT_VIEW(widget),
+                                       state->live_view_end);
+    return G_SOURCE_REMOVE;
+}
+
+static void live_view_append(AppState *state, const std::string &text) {
+    if (state->live_transcription_view == nullptr) return;
+    state->live_view_pending += text;
+    // While the window is hidden nothing is drawn; keep only what the
+    // view would show
+    size_t cap = LIVE_VIEW_MAX_CHARS * 4;  // UTF-8 bytes, generously
+    if (state->live_view_pending.size() > cap) {
+        size_t cut = state->live_view_pending.size() - cap;
+        while (cut < state->live_view_pending.size() &&
+               (state->live_view_pending[cut] & 0xC0) == 0x80) {
+            cut++;
+        }
+        state->live_view_pending.erase(0, cut);
+        gtk_text_buffer_set_text(live_view_buffer(state), "", -1);
+    }
+    if (state->live_view_tick_id == 0) {
+        state->live_view_tick_id = gtk_widget_add_tick_callback(
+            state->live_transcription_view, on_live_view_tick, state, nullptr);
+    }
+}
+
+static void live_view_clear(AppState *state) {
+    state->live_view_pending.clear();
+    if (state->live_transcription_view == nullptr) return;
+    if (state->live_view_tick_id != 0) {
+        gtk_widget_remove_tick_callback(state->live_transcription_view,
+                                        state->live_view_tick_id);
+        state->live_view_tick_id = 0;
+    }
+    gtk_text_buffer_set_text(live_view_buffer(state), "", -1);
+}
+
+// --- Base64 ---
+
+// Encodes straight into a caller-owned buffer, so the uplink can build
+// each frame in place.  The SIMD kernels are Muła's pshufb method: each
+// 16-byte lane turns 12 input bytes into 16 output characters.
+
+static constexpr char BASE64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static constexpr size_t base64_encoded_size(size_t n) {
+    return (n + 2) / 3 * 4;
+}
+
+using Base64Kernel = size_t (*)(const uint8_t *, size_t, char *);
+
+// Returns the number of input bytes consumed; the rest is left for the
+// scalar tail.  Never reads past `n`.
+static size_t base64_block_none(const uint8_t *, size_t, char *) {
+    return 0;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("ssse3")))
+static inline __m128i base64_lookup_ssse3(__m128i indices) {
+    const __m128i shift = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+        '/' - 63, 'A', 0, 0);
+    __m128i sel = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i lower = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    sel = _mm_or_si128(sel, _mm_and_si128(lower, _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(shift, sel), indices);
+}
+
+__attribute__((target("ssse3")))
+static size_t base64_block_ssse3(const uint8_t *in, size_t n, char *out) {
+    const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                        4, 5, 3, 4, 1, 2, 0, 1);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 12, out += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        x = _mm_shuffle_epi8(x, spread);
+        __m128i hi = _mm_mulhi_epu16(_mm_and_si128(x, _mm_set1_epi32(0x0fc0fc00)),
+                                     _mm_set1_epi32(0x04000040));
+        __m128i lo = _mm_mullo_epi16(_mm_and_si128(x, _mm_set1_epi32(0x003f03f0)),
+                                     _mm_set1_epi32(0x01000010));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                         base64_lookup_ssse3(_mm_or_si128(hi, lo)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t base64_block_avx2(const uint8_t *in, size_t n, char *out) {
+    const __m256i spread = _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i shift = _mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+        '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+        '/' - 63, 'A', 0, 0);
+    size_t i = 0;
+    for (; i + 28 <= n; i += 24, out += 32) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        __m128i b = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(in + i + 12));
+        __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+        x = _mm256_shuffle_epi8(x, spread);
+        __m256i hi = _mm256_mulhi_epu16(
+            _mm256_and_si256(x, _mm256_set1_epi32(0x0fc0fc00)),
+            _mm256_set1_epi32(0x04000040));
+        __m256i lo = _mm256_mullo_epi16(
+            _mm256_and_si256(x, _mm256_set1_epi32(0x003f03f0)),
+            _mm256_set1_epi32(0x01000010));
+        __m256i idx = _mm256_or_si256(hi, lo);
+        __m256i sel = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+        __m256i lower = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx);
+        sel = _mm256_or_si256(sel,
+                              _mm256_and_si256(lower, _mm256_set1_epi8(13)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+                            _mm256_add_epi8(_mm256_shuffle_epi8(shift, sel),
+                                            idx));
+    }
+    return i + base64_block_ssse3(in + i, n - i, out);
+}
+#endif
+
+static Base64Kernel select_base64_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return base64_block_avx2;
+    if (__builtin_cpu_supports("ssse3")) return base64_block_ssse3;
+#endif
+    return base64_block_none;
+}
+
+// Writes exactly base64_encoded_size(n) characters, no terminator
+static void base64_encode_into(const uint8_t *in, size_t n, char *out) {
+    static const Base64Kernel block = select_base64_kernel();
+    size_t i = block(in, n, out);
+    out += i / 3 * 4;
+    for (; i + 3 <= n; i += 3, out += 4) {
+        uint32_t v = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) |
+                     in[i + 2];
+        out[0] = BASE64_ALPHABET[v >> 18];
+        out[1] = BASE64_ALPHABET[(v >> 12) & 63];
+        out[2] = BASE64_ALPHABET[(v >> 6) & 63];
+        out[3] = BASE64_ALPHABET[v & 63];
+    }
+    if (i < n) {
+        uint32_t v = uint32_t(in[i]) << 16;
+        if (i + 1 < n) v |= uint32_t(in[i + 1]) << 8;
+        out[0] = BASE64_ALPHABET[v >> 18];
+        out[1] = BASE64_ALPHABET[(v >> 12) & 63];
+        out[2] = i + 1 < n ? BASE64_ALPHABET[(v >> 6) & 63] : '=';
+        out[3] = '=';
+    }
+}
+
+// --- Real-time transcription (WebSocket) ---
+
+static constexpr const char *WS_SESSION_UPDATE =
+    "{\"type\":\"session.update\",\"session\":"
+    "{\"audio_format\":{\"encoding\":\"pcm_s16le\","
+    "\"sample_rate\":16000}}}";
+
+// The realtime API only takes audio as JSON text messages, so each
+// append is built in one reused buffer: envelope, then base64 written
+// in place, then the closing brace.
+static constexpr char WS_APPEND_PREFIX[] =
+    "{\"type\":\"input_audio.append\",\"audio\":\"";
+static constexpr char WS_APPEND_SUFFIX[] = "\"}";
+
+static constexpr size_t ws_append_size(size_t samples) {
+    return sizeof(WS_APPEND_PREFIX) - 1 +
+           base64_encoded_size(samples * sizeof(int16_t)) +
+           sizeof(WS_APPEND_SUFFIX) - 1;
+}
+
+// Frame sizes offered in Settings.  Each message costs 48 bytes of
+// envelope and masked WebSocket header (40 + 8) plus the server's
+// per-message work, so larger frames are cheaper but hold audio back for
+// longer.  Rounded to whole VAD frames, the 50 ms preset sends 48 ms
+// messages (1250 a minute) and the 200 ms preset 208 ms ones (about 290).
+static const int UPLINK_FRAME_CHOICES_MS[] = {20, 50, 100, 200};
+
+static int snap_uplink_frame_ms(int ms, int fallback) {
+    for (int choice : UPLINK_FRAME_CHOICES_MS) {
+        if (choice == ms) return ms;
+    }
+    return fallback;
+}
+
+// Returns the NUL-terminated message, valid until the next call
+static const char *ws_build_append(std::string *frame, const int16_t *samples,
+                                   size_t count) {
+    size_t prefix = sizeof(WS_APPEND_PREFIX) - 1;
+    size_t encoded = base64_encoded_size(count * sizeof(int16_t));
+    frame->resize(ws_append_size(count));  // keeps capacity once grown
+    char *out = &(*frame)[0];
+    std::memcpy(out, WS_APPEND_PREFIX, prefix);
+    base64_encode_into(reinterpret_cast<const uint8_t *>(samples),
+                       count * sizeof(int16_t), out + prefix);
+    std::memcpy(out + prefix + encoded, WS_APPEND_SUFFIX,
+                sizeof(WS_APPEND_SUFFIX) - 1);
+    return frame->c_str();
+}
+
+// The TCP socket under a WebSocket connection, through any TLS and
+// libsoup wrapper streams; -1 if there isn't one
+static int uplink_socket_fd(GIOStream *stream) {
+    for (int depth = 0; stream != nullptr && depth < 4; depth++) {
+        if (G_IS_SOCKET_CONNECTION(stream)) {
+            GSocket *socket =
+                g_socket_connection_get_socket(G_SOCKET_CONNECTION(stream));
+            return g_socket_get_fd(socket);
+        }
+        const char *prop = nullptr;
+        for (const char *name : {"base-io-stream", "base-iostream"}) {
+            if (g_object_class_find_property(G_OBJECT_GET_CLASS(stream),
+                                             name) != nullptr) {
+                prop = name;
+            }
+        }
+        if (prop == nullptr) break;
+        GIOStream *base = nullptr;
+        g_object_get(stream, prop, &base, nullptr);
+        if (base != nullptr) g_object_unref(base);  // owned by `stream`
+        stream = base;
+    }
+    return -1;
+}
+
+// Find the socket of a newly adopted connection for send queue checks
+static void ws_track_socket(AppState *state) {
+    state->ws_socket_fd = uplink_socket_fd(
+        soup_websocket_connection_get_io_stream(state->ws_conn));
+    state->ws_socket_high_water = UPLINK_SOCKET_HIGH_WATER;
+    int sndbuf = 0;
+    socklen_t len = sizeof(sndbuf);
+    if (state->ws_socket_fd >= 0 &&
+        getsockopt(state->ws_socket_fd, SOL_SOCKET, SO_SNDBUF, &sndbuf,
+                   &len) == 0 && sndbuf > 0) {
+        // Past the kernel buffer the excess would pile up in libsoup
+        state->ws_socket_high_water =
+            std::min(UPLINK_SOCKET_HIGH_WATER, sndbuf / 2);
+    }
+    if (state->ws_socket_fd < 0) {
+        g_message("Realtime socket not found — uplink backpressure disabled");
+    }
+}
+
+// Bytes written to the socket but not yet acknowledged by the peer
+static int ws_socket_queued(AppState *state) {
+    int queued = 0;
+    if (state->ws_socket_fd < 0 ||
+        ioctl(state->ws_socket_fd, SIOCOUTQ, &queued) != 0)
+        return 0;
+    return queued;
+}
+
+// Handshake request for a new realtime session
+static SoupMessage *ws_new_message(AppState *state) {
+    SoupMessage *msg = soup_message_new(
+        "GET",
+        "wss://api.mistral.ai/v1/audio/transcriptions/realtime"
+        "?model=voxtral-mini-transcribe-realtime-2602");
+    soup_message_add_flags(msg, SOUP_MESSAGE_COLLECT_METRICS);
+
+    SoupMessageHeaders *headers = soup_message_get_request_headers(msg);
+    std::string auth = "Bearer " + state->api_key;
+    soup_message_headers_replace(headers, "Authorization", auth.c_str());
+    return msg;
+}
+
+// Send what was held back during session setup, oldest first
+static void ws_flush_preroll(AppState *state) {
+    state->ws_buffering = false;
+    PrerollBuffer *p = &state->ws_preroll;
+    if (p->size == 0) return;
+
+    g_message("Sending %.2f s of audio captured during session setup",
+              static_cast<double>(p->size) / WS_SAMPLE_RATE);
+    if (p->dropped > 0) {
+        g_warning("Session setup outlasted the pre-roll buffer, %.2f s lost",
+                  static_cast<double>(p->dropped) / WS_SAMPLE_RATE);
+    }
+    size_t cap = p->buf.size();
+    while (p->size > 0) {
+        size_t n = std::min({p->size, cap - p->start, WS_PREROLL_SEND_SAMPLES});
+        ws_queue_audio(state, p->buf.data() + p->start, n, true);
+        p->start = (p->start + n) % cap;
+        p->size -= n;
+    }
+}
+
+static void on_ws_message(SoupWebsocketConnection * /*conn*/, gint /*type*/,
+                          GBytes *message, gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+
+    gsize len = 0;
+    const char *data = static_cast<const char *>(
+        g_bytes_get_data(message, &len));
+
+    JsonParser *parser = json_parser_new();
+    if (!json_parser_load_from_data(parser, data, static_cast<gssize>(len),
+                                     nullptr)) {
+        g_object_unref(parser);
+        return;
+    }
+
+    JsonNode *root = json_parser_get_root(parser);
+    JsonObject *obj = json_node_get_object(root);
+    const char *msg_type = json_object_get_string_member(obj, "type");
+
+    if (g_strcmp0(msg_type, "session.created") == 0) {
+        // Send session.update with audio format
+        soup_websocket_connection_send_text(state->ws_conn, WS_SESSION_UPDATE);
+
+    } else if (g_strcmp0(msg_type, "session.updated") == 0) {
+        ws_session_ready(state);
+
+    } else if (g_strcmp0(msg_type, "transcription.text.delta") == 0) {
+        if (json_object_has_member(obj, "text")) {
+            const char *text = json_object_get_string_member(obj, "text");
+            if (text != nullptr) ws_receive_text(state, text);
+        }
+
+    } else if (g_strcmp0(msg_type, "error") == 0) {
+        const char *detail = "";
+        if (json_object_has_member(obj, "message")) {
+            detail = json_object_get_string_member(obj, "message");
+        }
+        g_warning("WebSocket transcription error: %s", detail);
+        ws_disconnect(state);
+    }
+
+    g_object_unref(parser);
+}
+
+static void on_ws_closed(SoupWebsocketConnection * /*conn*/,
+                         gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    if (state->ws_conn != nullptr) {
+        g_object_unref(state->ws_conn);
+        state->ws_conn = nullptr;
+    }
+    state->ws_ready = false;
+    state->ws_socket_fd = -1;
+
+    // A session that dropped by itself is resumed in a new one
+    if (!state->ws_closing && (state->dictating || state->recording)) {
+        ws_session_lost(state);
+        return;
+    }
+    state->ws_buffering = false;
+
+    // If dictating, stop gracefully
+    if (state->dictating) {
+        stop_dictation(state);
+    }
+}
+
+static void on_ws_connect_complete(GObject *source, GAsyncResult *result,
+                                   gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+
+    GError *error = nullptr;
+    log_connection_metrics(
+        "Realtime connect",
+        soup_session_get_async_result_message(SOUP_SESSION(source), result));
+    SoupWebsocketConnection *conn =
+        soup_session_websocket_connect_finish(SOUP_SESSION(source), result,
+                                              &error);
+    if (error != nullptr) {
+        g_warning("WebSocket connect failed: %s", error->message);
+        g_error_free(error);
+        if (state->ws_reconnecting && ws_retry_connect(state)) return;
+        state->ws_reconnecting = false;
+        state->ws_buffering = false;
+        if (state->dictating) {
+            stop_dictation(state);
+        }
+        return;
+    }
+
+    if (state->ws_closing) {
+        // Stopped while connecting
+        soup_websocket_connection_close(conn, SOUP_WEBSOCKET_CLOSE_NORMAL,
+                                        nullptr);
+        g_object_unref(conn);
+        return;
+    }
+
+    state->ws_conn = conn;
+    ws_track_socket(state);
+    g_signal_connect(conn, "message", G_CALLBACK(on_ws_message), state);
+    g_signal_connect(conn, "closed", G_CALLBACK(on_ws_closed), state);
+}
+
+// --- Realtime standby session ---
+
+// Setting up a realtime session takes a connect, session.created and a
+// session.update round trip, and audio captured meanwhile is dropped.
+// With `realtime_standby` on, one session is kept open and configured in
+// the background; ws_connect() adopts it at once and a replacement is
+// opened straight away.  The parked session is replaced every
+// WS_STANDBY_REFRESH_SECONDS, well before the server would close it.
+
+static constexpr guint WS_STANDBY_REFRESH_SECONDS = 240;
+static constexpr guint WS_STANDBY_KEEPALIVE_SECONDS = 20;
+static constexpr guint WS_STANDBY_RETRY_SECONDS = 5;
+static constexpr guint WS_STANDBY_RETRY_MAX_SECONDS = 300;
+
+static void standby_drop(AppState *state);
+
+static gboolean on_standby_timer(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    state->ws_standby_timer_id = 0;
+    standby_drop(state);
+    standby_open(state);
+    return G_SOURCE_REMOVE;
+}
+
+static void standby_set_timer(AppState *state, guint seconds) {
+    if (state->ws_standby_timer_id != 0) {
+        g_source_remove(state->ws_standby_timer_id);
+    }
+    state->ws_standby_timer_id =
+        g_timeout_add_seconds(seconds, on_standby_timer, state);
+}
+
+static void standby_retry_later(AppState *state) {
+    guint delay = std::min(WS_STANDBY_RETRY_MAX_SECONDS,
+                           WS_STANDBY_RETRY_SECONDS
+                               << std::min(state->ws_standby_failures, 6));
+    state->ws_standby_failures++;
+    standby_set_timer(state, delay);
+}
+
+// Close the parked session, if any, without further callbacks
+static void standby_drop(AppState *state) {
+    SoupWebsocketConnection *conn = state->ws_standby;
+    if (conn == nullptr) return;
+    state->ws_standby = nullptr;
+    state->ws_standby_ready = false;
+    g_signal_handlers_disconnect_by_data(conn, state);
+    if (soup_websocket_connection_get_state(conn) ==
+        SOUP_WEBSOCKET_STATE_OPEN) {
+        soup_websocket_connection_close(conn, SOUP_WEBSOCKET_CLOSE_NORMAL,
+                                        nullptr);
+    }
+    g_object_unref(conn);
+}
+
+static void standby_stop(AppState *state) {
+    if (state->ws_standby_timer_id != 0) {
+        g_source_remove(state->ws_standby_timer_id);
+        state->ws_standby_timer_id = 0;
+    }
+    if (state->ws_standby_cancel != nullptr) {
+        g_cancellable_cancel(state->ws_standby_cancel);
+        g_clear_object(&state->ws_standby_cancel);
+        state->ws_standby_connecting = false;
+    }
+    standby_drop(state);
+}
+
+static void on_standby_message(SoupWebsocketConnection *conn, gint /*type*/,
+                               GBytes *message, gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+
+    gsize len = 0;
+    const char *data = static_cast<const char *>(
+        g_bytes_get_data(message, &len));
+    JsonParser *parser = json_parser_new();
+    if (!json_parser_load_from_data(parser, data, static_cast<gssize>(len),
+                                     nullptr)) {
+        g_object_unref(parser);
+        return;
+    }
+    JsonObject *obj = json_node_get_object(json_parser_get_root(parser));
+    const char *msg_type = json_object_get_string_member(obj, "type");
+
+    if (g_strcmp0(msg_type, "session.created") == 0) {
+        soup_websocket_connection_send_text(conn, WS_SESSION_UPDATE);
+    } else if (g_strcmp0(msg_type, "session.updated") == 0) {
+        state->ws_standby_ready = true;
+        state->ws_standby_failures = 0;
+        g_message("Realtime standby session ready");
+    } else if (g_strcmp0(msg_type, "error") == 0) {
+        const char *detail = json_object_has_member(obj, "message")
+                                 ? json_object_get_string_member(obj, "message")
+                                 : "";
+        g_warning("Realtime standby session error: %s", detail);
+        standby_drop(state);
+        standby_retry_later(state);
+    }
+    g_object_unref(parser);
+}
+
+static void on_standby_closed(SoupWebsocketConnection *conn,
+                              gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    if (conn != state->ws_standby) return;
+    standby_drop(state);
+    standby_retry_later(state);
+}
+
+static void on_standby_connect_complete(GObject *source, GAsyncResult *result,
+                                        gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+
+    GError *error = nullptr;
+    SoupWebsocketConnection *conn =
+        soup_session_websocket_connect_finish(SOUP_SESSION(source), result,
+                                              &error);
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        // standby_stop() has already moved on; a newer connect may be
+        // in flight, so leave the state alone
+        g_error_free(error);
+        return;
+    }
+    state->ws_standby_connecting = false;
+    g_clear_object(&state->ws_standby_cancel);
+    if (error != nullptr) {
+        g_message("Realtime standby connect failed: %s", error->message);
+        g_error_free(error);
+        if (state->realtime_standby) standby_retry_later(state);
+        return;
+    }
+    bool stale_key = state->ws_standby_key != state->api_key;
+    if (!state->realtime_standby || !state->transcription_available ||
+        state->ws_standby != nullptr || stale_key) {
+        // Turned off, replaced or opened with an old key while connecting
+        soup_websocket_connection_close(conn, SOUP_WEBSOCKET_CLOSE_NORMAL,
+                                        nullptr);
+        g_object_unref(conn);
+        if (stale_key) standby_open(state);
+        return;
+    }
+
+    state->ws_standby = conn;
+    soup_websocket_connection_set_keepalive_interval(
+        conn, WS_STANDBY_KEEPALIVE_SECONDS);
+    g_signal_connect(conn, "message", G_CALLBACK(on_standby_message), state);
+    g_signal_connect(conn, "closed", G_CALLBACK(on_standby_closed), state);
+    standby_set_timer(state, WS_STANDBY_REFRESH_SECONDS);
+}
+
+// Start opening a parked session if standby is on and there isn't one
+static void standby_open(AppState *state) {
+    if (!state->realtime_standby || !state->transcription_available) return;
+    if (state->ws_standby != nullptr || state->ws_standby_connecting) return;
+
+    state->ws_standby_connecting = true;
+    state->ws_standby_cancel = g_cancellable_new();
+    state->ws_standby_key = state->api_key;
+    SoupMessage *msg = ws_new_message(state);
+    soup_session_websocket_connect_async(state->soup_session, msg, nullptr,
+                                         nullptr, G_PRIORITY_LOW,
+                                         state->ws_standby_cancel,
+                                         on_standby_connect_complete, state);
+    g_object_unref(msg);
+}
+
+// Apply the setting, e.g. after the API key changed
+static void standby_configure(AppState *state) {
+    standby_stop(state);
+    state->ws_standby_failures = 0;
+    standby_open(state);
+}
+
+// Detach the parked session if it is ready; the caller owns it
+static SoupWebsocketConnection *standby_claim(AppState *state) {
+    SoupWebsocketConnection *conn = state->ws_standby;
+    if (conn == nullptr || !state->ws_standby_ready ||
+        soup_websocket_connection_get_state(conn) !=
+            SOUP_WEBSOCKET_STATE_OPEN)
+        return nullptr;
+
+    g_signal_handlers_disconnect_by_data(conn, state);
+    state->ws_standby = nullptr;
+    state->ws_standby_ready = false;
+    if (state->ws_standby_timer_id != 0) {
+        g_source_remove(state->ws_standby_timer_id);
+        state->ws_standby_timer_id = 0;
+    }
+    return conn;
+}
+
+// Make the parked session the live one, if it is ready
+static bool standby_take(AppState *state) {
+    SoupWebsocketConnection *conn = standby_claim(state);
+    if (conn == nullptr) return false;
+
+    state->ws_conn = conn;
+    state->ws_ready = true;
+    ws_track_socket(state);
+    g_signal_connect(conn, "message", G_CALLBACK(on_ws_message), state);
+    g_signal_connect(conn, "closed", G_CALLBACK(on_ws_closed), state);
+    g_message("Using standby realtime session");
+
+    standby_open(state);  // replenish
+    return true;
+}
+
+static void ws_connect(AppState *state) {
+    if (!state->transcription_available) return;
+    if (state->ws_conn != nullptr) return;
+
+    state->live_transcription.clear();
+    state->ws_ready = false;
+    state->ws_closing = false;
+    state->ws_reconnect_attempts = 0;
+    retain_reset(&state->ws_retained);
+    state->ws_recent_text.clear();
+    state->ws_session_started_us = g_get_monotonic_time();
+    state->ws_rotations = 0;
+    if (state->vad.sample_rate != WS_SAMPLE_RATE) {
+        vad_init(&state->vad, WS_SAMPLE_RATE);
+    }
+    vad_reset(&state->vad);
+
+    // Hold audio until the session is ready
+    preroll_reset(&state->ws_preroll, WS_PREROLL_SECONDS * WS_SAMPLE_RATE);
+    state->ws_buffering = true;
+
+    // Dictation wants words back quickly; a live transcript can trade a
+    // little latency for fewer, larger messages.  Frames are whole VAD
+    // frames, so the target is rounded to 16 ms.
+    int frame_ms = state->dictating ? state->dictation_frame_ms
+                                    : state->live_frame_ms;
+    size_t frame_samples = static_cast<size_t>(WS_SAMPLE_RATE) * frame_ms / 1000;
+    state->ws_frame_slots = std::max<size_t>(
+        1, (frame_samples + VAD_FRAME_SAMPLES / 2) / VAD_FRAME_SAMPLES);
+    state->ws_budget_ms = state->dictating ? UPLINK_BUDGET_DICTATION_MS
+                                           : UPLINK_BUDGET_LIVE_MS;
+    uplink_reset(&state->ws_queue,
+                 (UPLINK_QUEUE_SECONDS + WS_PREROLL_SECONDS + WS_RETAIN_SECONDS) *
+                     WS_SAMPLE_RATE / VAD_FRAME_SAMPLES);
+    state->ws_scratch.reserve(UPLINK_MAX_MESSAGE_SLOTS * VAD_FRAME_SAMPLES);
+    state->ws_frame.reserve(
+        ws_append_size(UPLINK_MAX_MESSAGE_SLOTS * VAD_FRAME_SAMPLES));
+    state->ws_lag_ms = 0;
+    if (standby_take(state)) {
+        state->ws_buffering = false;
+        return;
+    }
+
+    SoupMessage *msg = ws_new_message(state);
+    soup_session_websocket_connect_async(state->soup_session, msg, nullptr,
+                                         nullptr, G_PRIORITY_DEFAULT, nullptr,
+                                         on_ws_connect_complete, state);
+    g_object_unref(msg);
+}
+
+#ifndef NDEBUG
+// Debug builds check that the send path's own buffers are reused: every
+// time one of them has to grow it is counted as an allocation.  GLib's
+// allocations (libsoup's frame copy) are not seen.
+static size_t uplink_buffer_capacity(AppState *state, size_t i) {
+    switch (i) {
+    case 0: return state->ws_frame.capacity();
+    case 1: return state->ws_scratch.capacity();
+    case 2: return state->vad_out.capacity();
+    default: return state->vad_speech.capacity();
+    }
+}
+static constexpr size_t UPLINK_BUFFERS = 4;
+#endif
+
+static void ws_send_frame(AppState *state, const int16_t *samples,
+                          size_t count) {
+    const char *msg = ws_build_append(&state->ws_frame, samples, count);
+    soup_websocket_connection_send_text(state->ws_conn, msg);
+    state->ws_frames_sent++;
+    state->ws_bytes_sent += state->ws_frame.size();
+    state->ws_samples_sent += count;
+    retain_push(&state->ws_retained, samples, count, g_get_monotonic_time());
+}
+
+static void ws_send_queued(AppState *state, size_t slots, gint64 now) {
+    state->ws_queue.backlog_sent +=
+        uplink_pop(&state->ws_queue, slots, state->ws_scratch, now);
+    ws_send_frame(state, state->ws_scratch.data(), state->ws_scratch.size());
+}
+
+static constexpr int UPLINK_WIRE_BYTES_PER_SECOND =
+    static_cast<int>(ws_append_size(WS_SAMPLE_RATE));
+static constexpr int UPLINK_COALESCE_MS = 250;  // lag that merges frames
+
+// Backlog is left out: it isn't late, it was held on purpose
+static int uplink_lag_ms(AppState *state, int socket_queued) {
+    const UplinkQueue *q = &state->ws_queue;
+    size_t queued_samples = (q->count - q->backlog) * VAD_FRAME_SAMPLES;
+    return static_cast<int>(queued_samples * 1000 / WS_SAMPLE_RATE) +
+           socket_queued * 1000 / UPLINK_WIRE_BYTES_PER_SECOND;
+}
+
+// Uplink lag on the tray label once it is large enough to notice.  The
+// window's status label is left alone: it also carries batch progress.
+static void show_uplink_lag(AppState *state) {
+    int shown = state->ws_lag_ms >= UPLINK_LAG_SHOW_MS
+                    ? (state->ws_lag_ms + 50) / 100
+                    : 0;
+    if (shown == state->ws_lag_shown) return;
+    state->ws_lag_shown = shown;
+
+    char lag[64] = "";
+    if (shown > 0) {
+        g_snprintf(lag, sizeof(lag), "%.1f s behind", shown / 10.0);
+    }
+    if (state->indicator != nullptr) {
+        app_indicator_set_label(state->indicator, lag, "00.0 s behind");
+    }
+}
+
+// Hand queued audio to libsoup while the socket has room.  Frames go out
+// at the session's target size; once the uplink lags they are merged so
+// the envelope overhead shrinks while catching up.  `flush` also sends a
+// final partial frame.
+static void ws_pump_uplink(AppState *state, bool flush) {
+    UplinkQueue *q = &state->ws_queue;
+    gint64 now = g_get_monotonic_time();
+    for (;;) {
+        int queued = ws_socket_queued(state);
+        state->ws_lag_ms = uplink_lag_ms(state, queued);
+        if (state->ws_lag_ms > state->ws_budget_ms && q->count > q->backlog) {
+            size_t excess_samples = static_cast<size_t>(
+                state->ws_lag_ms - state->ws_budget_ms) * WS_SAMPLE_RATE / 1000;
+            size_t excess = std::min(
+                q->count - q->backlog,
+                (excess_samples + VAD_FRAME_SAMPLES - 1) / VAD_FRAME_SAMPLES);
+            uplink_shed(q, excess);
+            state->ws_lag_ms = uplink_lag_ms(state, queued);
+        }
+        if (q->count == 0 || queued >= state->ws_socket_high_water) break;
+
+        size_t frame = state->ws_frame_slots;
+        size_t n;
+        // Backlog goes out in large messages too, to catch up
+        if ((state->ws_lag_ms >= UPLINK_COALESCE_MS || q->backlog > 0) &&
+            q->count > frame) {
+            n = std::min(q->count, UPLINK_MAX_MESSAGE_SLOTS);
+        } else if (q->count >= frame) {
+            n = frame;
+        } else if (flush) {
+            n = q->count;
+        } else {
+            break;
+        }
+        ws_send_queued(state, n, now);
+    }
+    show_uplink_lag(state);
+
+    // Confirm held audio made it out once the last of it has gone
+    if (q->backlog == 0 && q->backlog_sent + q->backlog_dropped > 0) {
+        double slot_seconds =
+            static_cast<double>(VAD_FRAME_SAMPLES) / WS_SAMPLE_RATE;
+        double sent = static_cast<double>(q->backlog_sent) * slot_seconds;
+        if (q->backlog_dropped > 0) {
+            g_warning("Only %.1f s of %.1f s of held audio reached the "
+                      "session", sent,
+                      sent + static_cast<double>(q->backlog_dropped) *
+                                 slot_seconds);
+        } else {
+            g_message("All %.1f s of held audio handed to the session", sent);
+        }
+        q->backlog_sent = 0;
+        q->backlog_dropped = 0;
+    }
+}
+
+// Send everything still queued, regardless of the socket
+static void ws_flush_uplink(AppState *state) {
+    UplinkQueue *q = &state->ws_queue;
+    if (!state->ws_ready || state->ws_conn == nullptr) {
+        q->head = 0;
+        q->count = 0;
+        q->backlog = 0;
         return;
     }
+    gint64 now = g_get_monotonic_time();
+    while (q->count > 0) {
+        ws_send_queued(state, std::min(q->count, UPLINK_MAX_MESSAGE_SLOTS),
+                       now);
+    }
+}
 
-    pa_stream_set_write_callback(state->playback_stream,
-                                 on_playback_write, state);
-    pa_stream_set_state_callback(state->playback_stream,
-                                 on_playback_stream_state, state);
+static void log_uplink_summary(AppState *state) {
+    UplinkQueue *q = &state->ws_queue;
+    if (q->dropped_silence + q->dropped_speech > 0) {
+        double slot_seconds =
+            static_cast<double>(VAD_FRAME_SAMPLES) / WS_SAMPLE_RATE;
+        g_warning("Uplink fell behind: dropped %.1f s of pauses and %.1f s "
+                  "of speech to stay within %d ms",
+                  static_cast<double>(q->dropped_silence) * slot_seconds,
+                  static_cast<double>(q->dropped_speech) * slot_seconds,
+                  state->ws_budget_ms);
+        q->dropped_silence = 0;
+        q->dropped_speech = 0;
+    }
+    if (state->ws_frames_sent == 0) return;
+    double frames = static_cast<double>(state->ws_frames_sent);
+    double audio_bytes =
+        static_cast<double>(state->ws_samples_sent) * sizeof(int16_t);
+    double overhead = 1.0 - audio_bytes /
+                                static_cast<double>(state->ws_bytes_sent);
+    g_message("Uplink sent %.0f frames averaging %.0f ms "
+              "(%.0f%% encoding and envelope overhead, "
+              "longest queued %.0f ms)",
+              frames,
+              audio_bytes / sizeof(int16_t) / frames * 1000.0 / WS_SAMPLE_RATE,
+              100.0 * std::max(0.0, overhead),
+              static_cast<double>(q->max_age_us) / 1000.0);
+#ifndef NDEBUG
+    g_message("Uplink send path regrew its buffers %" G_GUINT64_FORMAT
+              " times", state->ws_frame_allocs);
+#endif
+    state->ws_frames_sent = 0;
+    state->ws_bytes_sent = 0;
+    state->ws_samples_sent = 0;
+    state->ws_frame_allocs = 0;
+    q->max_age_us = 0;
+}
 
-    if (pa_stream_connect_playback(state->playback_stream, nullptr, nullptr,
-                                   PA_STREAM_NOFLAGS, nullptr, nullptr) < 0) {
-        gtk_label_set_text(GTK_LABEL(state->label),
-                           "Failed to connect playback");
-        pa_stream_unref(state->playback_stream);
-        state->playback_stream = nullptr;
+static void ws_disconnect(AppState *state) {
+    state->ws_closing = true;
+    state->ws_reconnecting = false;
+    if (state->ws_reconnect_id != 0) {
+        g_source_remove(state->ws_reconnect_id);
+        state->ws_reconnect_id = 0;
+    }
+    ws_rotate_stop(state);
+    ws_dedupe_finish(state);
+    ws_flush_uplink(state);
+    state->ws_ready = false;
+    state->ws_buffering = false;
+    log_uplink_summary(state);
+    state->ws_lag_ms = 0;
+    if (state->ws_lag_shown != 0 && state->indicator != nullptr) {
+        app_indicator_set_label(state->indicator, "", "");
+    }
+    state->ws_lag_shown = 0;
+
+    VoiceGate *vad = &state->vad;
+    if (vad->frames_seen > 0) {
+        double seen = static_cast<double>(vad->frames_seen);
+        double sent = static_cast<double>(vad->frames_sent);
+        double frame_seconds =
+            static_cast<double>(VAD_FRAME_SAMPLES) / WS_SAMPLE_RATE;
+        g_message("Voice gate suppressed %.0f%% of uplink audio "
+                  "(sent %.1f s of %.1f s)",
+                  100.0 * std::max(0.0, 1.0 - sent / seen),
+                  sent * frame_seconds, seen * frame_seconds);
+        vad_reset(vad);
+    }
+    if (state->ws_conn != nullptr &&
+        soup_websocket_connection_get_state(state->ws_conn) ==
+            SOUP_WEBSOCKET_STATE_OPEN) {
+        soup_websocket_connection_close(state->ws_conn,
+                                        SOUP_WEBSOCKET_CLOSE_NORMAL, nullptr);
+    }
+}
+
+// Samples must already be at WS_SAMPLE_RATE — PulseAudio resamples for us.
+// Silence is held back by the voice gate and never sent.
+static void ws_send_audio(AppState *state, const int16_t *samples,
+                          size_t count) {
+    if (count == 0) return;
+    if (!state->ws_ready || state->ws_conn == nullptr) {
+        if (state->ws_buffering) {
+            preroll_push(&state->ws_preroll, samples, count);
+        }
         return;
     }
+    ws_queue_audio(state, samples, count, false);
+}
 
-    state->playing = true;
-    state->playing_note_index = note_index;
+// Gate `samples` into the uplink queue and send what the socket takes.
+// `backlog` marks audio held while the session was being set up.
+static void ws_queue_audio(AppState *state, const int16_t *samples,
+                           size_t count, bool backlog) {
+#ifndef NDEBUG
+    size_t capacity_before[UPLINK_BUFFERS];
+    for (size_t i = 0; i < UPLINK_BUFFERS; i++) {
+        capacity_before[i] = uplink_buffer_capacity(state, i);
+    }
+#endif
+    state->vad_out.clear();
+    state->vad_speech.clear();
+    vad_process(&state->vad, samples, count, state->vad_out,
+                state->vad_speech);
+
+    gint64 now = g_get_monotonic_time();
+    for (size_t f = 0; f < state->vad_speech.size(); f++) {
+        uplink_push(&state->ws_queue,
+                    state->vad_out.data() + f * VAD_FRAME_SAMPLES,
+                    state->vad_speech[f] != 0, backlog, now);
+    }
+    // When the gate has closed, don't hold the end of an utterance back
+    ws_pump_uplink(state, state->vad_out.empty());
+    ws_rotate_tick(state);
+#ifndef NDEBUG
+    for (size_t i = 0; i < UPLINK_BUFFERS; i++) {
+        if (uplink_buffer_capacity(state, i) != capacity_before[i]) {
+            state->ws_frame_allocs++;
+        }
+    }
+#endif
+}
 
-    char buf[128];
-    g_snprintf(buf, sizeof(buf), "Playing: %s", note.display_name.c_str());
-    gtk_label_set_text(GTK_LABEL(state->label), buf);
+// --- Realtime session recovery ---
+
+// A session that drops while dictating or recording (Wi-Fi roaming, a
+// server restart) is replaced without stopping anything.  Audio keeps
+// collecting in the pre-roll buffer while reconnecting, with jittered
+// exponential backoff.  Once the new session is ready, the retained
+// audio the old one may not have transcribed is replayed, and the text
+// it produces again is trimmed against what was already delivered.
+
+static constexpr guint WS_RECONNECT_BASE_MS = 500;
+static constexpr guint WS_RECONNECT_MAX_MS = 10000;
+static constexpr int WS_RECONNECT_MAX_ATTEMPTS = 8;
+static constexpr size_t WS_RECENT_TEXT_MAX = 1024;   // bytes of tail kept
+static constexpr size_t WS_DEDUPE_WORDS = 40;        // compared at most
+static constexpr size_t WS_DEDUPE_MIN_OVERLAP = 2;   // words
+static constexpr guint WS_DEDUPE_TIMEOUT_MS = 6000;
+
+// Deliver transcript text to whoever is listening
+static void ws_emit_text(AppState *state, const std::string &text) {
+    if (text.empty()) return;
+    state->ws_recent_text += text;
+    if (state->ws_recent_text.size() > WS_RECENT_TEXT_MAX) {
+        state->ws_recent_text.erase(
+            0, state->ws_recent_text.size() - WS_RECENT_TEXT_MAX);
+    }
 
-    refresh_notes_list(state);
+    if (state->dictating) {
+        type_text(state, text.c_str());
+        return;
+    }
+    state->live_transcription += text;
+    live_view_append(state, text);
+    // Journal the delta for crash safety
+    journal_append(&state->journal, text);
 }
 
-static void stop_playback(AppState *state) {
-    if (state->playback_stream != nullptr) {
-        pa_stream_disconnect(state->playback_stream);
-        pa_stream_unref(state->playback_stream);
-        state->playback_stream = nullptr;
+struct TranscriptWord {
+    std::string key;  // lowercased, punctuation removed
+    size_t end;       // byte offset just past the word
+};
+
+static std::vector<TranscriptWord> split_transcript_words(
+    const std::string &text) {
+    std::vector<TranscriptWord> words;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && g_ascii_isspace(text[i])) i++;
+        if (i == text.size()) break;
+        TranscriptWord w;
+        for (; i < text.size() && !g_ascii_isspace(text[i]); i++) {
+            auto c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x80 || g_ascii_isalnum(c)) {
+                w.key += static_cast<char>(g_ascii_tolower(c));
+            }
+        }
+        w.end = i;
+        if (!w.key.empty()) words.push_back(std::move(w));
     }
+    return words;
+}
 
-    bool was_playing = state->playing;
-    state->playing = false;
-    state->playing_note_index = -1;
-    state->playback_buffer.clear();
-    state->playback_offset = 0;
+enum class OverlapResult { WAIT, FOUND, NONE };
+
+// Does the new session's text start by repeating the end of `tail`?
+// FOUND sets `emit_from` to the byte offset where the new text begins;
+// WAIT means everything so far repeats the tail and more is needed to
+// tell.  The first pending word may be a fragment of a cut-off word.
+static OverlapResult find_replay_overlap(const std::string &tail,
+                                         const std::string &pending,
+                                         size_t *emit_from) {
+    std::vector<TranscriptWord> t = split_transcript_words(tail);
+    std::vector<TranscriptWord> p = split_transcript_words(pending);
+    if (t.size() > WS_DEDUPE_WORDS) {
+        t.erase(t.begin(), t.end() - WS_DEDUPE_WORDS);
+    }
+    if (p.empty()) return OverlapResult::WAIT;
+
+    bool waiting = false;
+    for (size_t skip = 0; skip <= 1 && skip < p.size(); skip++) {
+        // Longest overlap first
+        for (size_t j = 0; j < t.size(); j++) {
+            size_t run = t.size() - j;
+            size_t len = std::min(p.size() - skip, run);
+            bool match = true;
+            for (size_t k = 0; k < len && match; k++) {
+                match = p[skip + k].key == t[j + k].key;
+            }
+            if (!match) continue;
+            if (p.size() - skip <= run) {
+                waiting = true;  // still inside the tail
+                continue;
+            }
+            if (run < WS_DEDUPE_MIN_OVERLAP) continue;
+            *emit_from = p[skip + run - 1].end;
+            return OverlapResult::FOUND;
+        }
+    }
+    return waiting ? OverlapResult::WAIT : OverlapResult::NONE;
+}
 
-    if (was_playing) {
-        gtk_label_set_text(GTK_LABEL(state->label), "Ready");
-        refresh_notes_list(state);
+// Decide what to do with held deltas.  With `force`, text that still
+// only repeats the tail is dropped.
+static void ws_dedupe_check(AppState *state, bool force) {
+    size_t emit_from = 0;
+    OverlapResult r = find_replay_overlap(state->ws_recent_text,
+                                          state->ws_dedupe_text, &emit_from);
+    if (r == OverlapResult::WAIT && !force) return;
+
+    std::string text = std::move(state->ws_dedupe_text);
+    state->ws_dedupe_text.clear();
+    state->ws_dedupe = false;
+    if (state->ws_dedupe_id != 0) {
+        g_source_remove(state->ws_dedupe_id);
+        state->ws_dedupe_id = 0;
+    }
+
+    if (r == OverlapResult::FOUND) {
+        g_message("Trimmed %zu bytes of repeated text from the new session",
+                  emit_from);
+        ws_emit_text(state, text.substr(emit_from));
+    } else if (r == OverlapResult::NONE) {
+        ws_emit_text(state, text);
     }
 }
 
-// --- Audio resampler (44100→16000) ---
+static gboolean on_dedupe_timeout(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    state->ws_dedupe_id = 0;
+    ws_dedupe_check(state, true);
+    return G_SOURCE_REMOVE;
+}
+
+// Release anything still held, e.g. when the session is stopped
+static void ws_dedupe_finish(AppState *state) {
+    if (state->ws_dedupe) ws_dedupe_check(state, true);
+}
 
-static std::vector<int16_t> resample_44100_to_16000(const int16_t *input,
-                                                     size_t count,
-                                                     double *phase) {
-    static constexpr double STEP = static_cast<double>(SAMPLE_RATE) /
-                                   static_cast<double>(WS_SAMPLE_RATE);
-    std::vector<int16_t> output;
-    output.reserve(count / 2); // Rough estimate
+static void ws_receive_text(AppState *state, const char *text) {
+    retain_ack(&state->ws_retained, g_get_monotonic_time());
+    if (state->ws_retiring != nullptr) {
+        // A rotation is under way; the previous session's text goes first
+        state->ws_held_text += text;
+        return;
+    }
+    if (!state->ws_dedupe) {
+        ws_emit_text(state, text);
+        return;
+    }
+    state->ws_dedupe_text += text;
+    ws_dedupe_check(state, false);
+}
 
-    double pos = *phase;
-    while (pos < static_cast<double>(count) - 1.0) {
-        auto idx = static_cast<size_t>(pos);
-        double frac = pos - static_cast<double>(idx);
-        double sample = static_cast<double>(input[idx]) * (1.0 - frac) +
-                        static_cast<double>(input[idx + 1]) * frac;
-        output.push_back(static_cast<int16_t>(sample));
-        pos += STEP;
+// Queue the retained audio ahead of anything captured since the drop,
+// as backlog so the uplink budget doesn't shed it
+static void ws_replay_retained(AppState *state) {
+    PrerollBuffer *p = &state->ws_retained.audio;
+    if (p->size == 0) return;
+    g_message("Replaying %.1f s of audio the dropped session may have missed",
+              static_cast<double>(p->size) / WS_SAMPLE_RATE);
+
+    gint64 now = g_get_monotonic_time();
+    size_t cap = p->buf.size();
+    for (size_t off = 0; off + VAD_FRAME_SAMPLES <= p->size;
+         off += VAD_FRAME_SAMPLES) {
+        uplink_push(&state->ws_queue,
+                    p->buf.data() + (p->start + off) % cap, true, true, now);
     }
+    retain_reset(&state->ws_retained);  // re-retained as it is sent
 
-    *phase = pos - static_cast<double>(count);
-    return output;
+    state->ws_dedupe = !state->ws_recent_text.empty();
+    if (state->ws_dedupe) {
+        state->ws_dedupe_text.clear();
+        state->ws_dedupe_id =
+            g_timeout_add(WS_DEDUPE_TIMEOUT_MS, on_dedupe_timeout, state);
+    }
 }
 
-// Auto-scroll the live transcription text view to the bottom
-static void scroll_transcription_to_bottom(AppState *state) {
-    if (state->live_transcription_view == nullptr) return;
-    GtkTextBuffer *buf = gtk_text_view_get_buffer(
-        GTK_TEXT_VIEW(state->live_transcription_view));
-    GtkTextIter end;
-    gtk_text_buffer_get_end_iter(buf, &end);
-    GtkTextMark *mark = gtk_text_buffer_create_mark(buf, nullptr, &end, FALSE);
-    gtk_text_view_scroll_mark_onscreen(
-        GTK_TEXT_VIEW(state->live_transcription_view), mark);
-    gtk_text_buffer_delete_mark(buf, mark);
+// session.updated, or a standby session adopted on reconnect
+static void ws_session_ready(AppState *state) {
+    state->ws_ready = true;
+    state->ws_session_started_us = g_get_monotonic_time();
+    if (state->ws_reconnecting) {
+        g_message("Realtime session resumed after %d attempt%s",
+                  state->ws_reconnect_attempts,
+                  state->ws_reconnect_attempts == 1 ? "" : "s");
+        state->ws_reconnecting = false;
+        state->ws_reconnect_attempts = 0;
+        ws_replay_retained(state);
+        ws_pump_uplink(state, true);
+    }
+    ws_flush_preroll(state);
 }
 
-// --- Real-time transcription (WebSocket) ---
+static gboolean on_ws_reconnect(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    state->ws_reconnect_id = 0;
 
-static void on_ws_message(SoupWebsocketConnection * /*conn*/, gint /*type*/,
-                          GBytes *message, gpointer userdata) {
+    if (standby_take(state)) {
+        ws_session_ready(state);
+        return G_SOURCE_REMOVE;
+    }
+    SoupMessage *msg = ws_new_message(state);
+    soup_session_websocket_connect_async(state->soup_session, msg, nullptr,
+                                         nullptr, G_PRIORITY_DEFAULT, nullptr,
+                                         on_ws_connect_complete, state);
+    g_object_unref(msg);
+    return G_SOURCE_REMOVE;
+}
+
+// Schedule the next attempt; false once attempts are used up
+static bool ws_retry_connect(AppState *state) {
+    if (state->ws_reconnect_attempts >= WS_RECONNECT_MAX_ATTEMPTS) {
+        g_warning("Realtime session could not be resumed after %d attempts",
+                  state->ws_reconnect_attempts);
+        return false;
+    }
+    // Exponential, with jitter so a fleet of clients doesn't reconnect
+    // in lockstep after an outage
+    guint backoff = std::min(WS_RECONNECT_MAX_MS,
+                             WS_RECONNECT_BASE_MS
+                                 << std::min(state->ws_reconnect_attempts, 5));
+    guint delay = backoff / 2 + static_cast<guint>(g_random_double_range(
+                                    0.0, backoff / 2.0));
+    state->ws_reconnect_attempts++;
+    state->ws_reconnect_id = g_timeout_add(delay, on_ws_reconnect, state);
+    return true;
+}
+
+static void ws_session_lost(AppState *state) {
+    g_warning("Realtime session dropped — reconnecting");
+    ws_rotate_stop(state);
+    ws_dedupe_finish(state);
+
+    // Audio that never left joins the retained audio, so the replay
+    // stays in order
+    UplinkQueue *q = &state->ws_queue;
+    gint64 now = g_get_monotonic_time();
+    while (q->count > 0) {
+        size_t n = std::min(q->count, UPLINK_MAX_MESSAGE_SLOTS);
+        uplink_pop(q, n, state->ws_scratch, now);
+        retain_push(&state->ws_retained, state->ws_scratch.data(),
+                    state->ws_scratch.size(), now);
+    }
+
+    // Capture continues into the pre-roll until the new session is ready
+    if (!state->ws_reconnecting) {
+        preroll_reset(&state->ws_preroll,
+                      WS_PREROLL_SECONDS * WS_SAMPLE_RATE);
+    }
+    state->ws_buffering = true;
+    state->ws_reconnecting = true;
+    if (!ws_retry_connect(state)) {
+        state->ws_reconnecting = false;
+        state->ws_buffering = false;
+        if (state->dictating) stop_dictation(state);
+    }
+}
+
+// --- Realtime session rotation ---
+
+// One realtime session shouldn't carry an hours-long meeting, so after
+// WS_ROTATE_AFTER_SECONDS a successor is opened and configured in the
+// background (a ready standby session is claimed if there is one).  The
+// switch waits for a pause, when the voice gate is closed and nothing is
+// queued, so no word is split between the two.  The old session stays
+// open until its last deltas have arrived; the new one's text is held
+// meanwhile, then follows it.  Without a pause for WS_ROTATE_MAX_WAIT_SECONDS
+// the switch is forced: the last WS_ROTATE_OVERLAP_MS of audio goes to
+// both sessions and the repeated words are trimmed as after a reconnect.
+
+static constexpr gint64 WS_ROTATE_AFTER_SECONDS = 900;
+static constexpr gint64 WS_ROTATE_MAX_WAIT_SECONDS = 45;
+static constexpr gint64 WS_ROTATE_RETRY_SECONDS = 15;
+static constexpr size_t WS_ROTATE_OVERLAP_MS = 2000;
+static constexpr guint WS_ROTATE_QUIET_MS = 1500;    // after the last delta
+static constexpr gint64 WS_ROTATE_DRAIN_MAX_MS = 8000;
+
+static void ws_successor_drop(AppState *state) {
+    state->ws_successor_connecting = false;
+    SoupWebsocketConnection *conn = state->ws_successor;
+    if (conn == nullptr) return;
+    state->ws_successor = nullptr;
+    state->ws_successor_ready = false;
+    g_signal_handlers_disconnect_by_data(conn, state);
+    if (soup_websocket_connection_get_state(conn) ==
+        SOUP_WEBSOCKET_STATE_OPEN) {
+        soup_websocket_connection_close(conn, SOUP_WEBSOCKET_CLOSE_NORMAL,
+                                        nullptr);
+    }
+    g_object_unref(conn);
+}
+
+static void ws_successor_failed(AppState *state) {
+    ws_successor_drop(state);
+    state->ws_successor_retry_us =
+        g_get_monotonic_time() + WS_ROTATE_RETRY_SECONDS * G_USEC_PER_SEC;
+}
+
+static void on_successor_message(SoupWebsocketConnection *conn, gint /*type*/,
+                                 GBytes *message, gpointer userdata) {
     auto *state = static_cast<AppState *>(userdata);
 
     gsize len = 0;
     const char *data = static_cast<const char *>(
         g_bytes_get_data(message, &len));
-
     JsonParser *parser = json_parser_new();
     if (!json_parser_load_from_data(parser, data, static_cast<gssize>(len),
                                      nullptr)) {
         g_object_unref(parser);
         return;
     }
-
-    JsonNode *root = json_parser_get_root(parser);
-    JsonObject *obj = json_node_get_object(root);
+    JsonObject *obj = json_node_get_object(json_parser_get_root(parser));
     const char *msg_type = json_object_get_string_member(obj, "type");
 
     if (g_strcmp0(msg_type, "session.created") == 0) {
-        // Send session.update with audio format
-        const char *session_update =
-            "{\"type\":\"session.update\",\"session\":"
-            "{\"audio_format\":{\"encoding\":\"pcm_s16le\","
-            "\"sample_rate\":16000}}}";
-        soup_websocket_connection_send_text(state->ws_conn, session_update);
-
+        soup_websocket_connection_send_text(conn, WS_SESSION_UPDATE);
     } else if (g_strcmp0(msg_type, "session.updated") == 0) {
-        state->ws_ready = true;
+        state->ws_successor_ready = true;
+        state->ws_successor_ready_us = g_get_monotonic_time();
+    } else if (g_strcmp0(msg_type, "error") == 0) {
+        const char *detail = json_object_has_member(obj, "message")
+                                 ? json_object_get_string_member(obj, "message")
+                                 : "";
+        g_warning("Realtime successor session error: %s", detail);
+        ws_successor_failed(state);
+    }
+    g_object_unref(parser);
+}
 
-    } else if (g_strcmp0(msg_type, "transcription.text.delta") == 0) {
+static void on_successor_closed(SoupWebsocketConnection *conn,
+                                gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    if (conn == state->ws_successor) ws_successor_failed(state);
+}
+
+static void ws_successor_adopt(AppState *state, SoupWebsocketConnection *conn) {
+    state->ws_successor = conn;
+    soup_websocket_connection_set_keepalive_interval(
+        conn, WS_STANDBY_KEEPALIVE_SECONDS);
+    g_signal_connect(conn, "message", G_CALLBACK(on_successor_message), state);
+    g_signal_connect(conn, "closed", G_CALLBACK(on_successor_closed), state);
+}
+
+static void on_successor_connect_complete(GObject *source,
+                                          GAsyncResult *result,
+                                          gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+
+    GError *error = nullptr;
+    SoupWebsocketConnection *conn =
+        soup_session_websocket_connect_finish(SOUP_SESSION(source), result,
+                                              &error);
+    if (error != nullptr) {
+        g_message("Realtime successor connect failed: %s", error->message);
+        g_error_free(error);
+        if (state->ws_successor_connecting) ws_successor_failed(state);
+        return;
+    }
+    if (!state->ws_successor_connecting) {
+        // Recording stopped while connecting
+        soup_websocket_connection_close(conn, SOUP_WEBSOCKET_CLOSE_NORMAL,
+                                        nullptr);
+        g_object_unref(conn);
+        return;
+    }
+    state->ws_successor_connecting = false;
+    ws_successor_adopt(state, conn);
+}
+
+static void ws_successor_open(AppState *state) {
+    g_message("Realtime session open for %" G_GINT64_FORMAT
+              " s, preparing its successor",
+              (g_get_monotonic_time() - state->ws_session_started_us) /
+                  G_USEC_PER_SEC);
+    SoupWebsocketConnection *parked = standby_claim(state);
+    if (parked != nullptr) {
+        ws_successor_adopt(state, parked);
+        state->ws_successor_ready = true;
+        state->ws_successor_ready_us = g_get_monotonic_time();
+        standby_open(state);  // replenish
+        return;
+    }
+    state->ws_successor_connecting = true;
+    SoupMessage *msg = ws_new_message(state);
+    soup_session_websocket_connect_async(state->soup_session, msg, nullptr,
+                                         nullptr, G_PRIORITY_LOW, nullptr,
+                                         on_successor_connect_complete, state);
+    g_object_unref(msg);
+}
+
+// Close the previous session and release the text held behind it
+static void ws_retire_finish(AppState *state) {
+    SoupWebsocketConnection *conn = state->ws_retiring;
+    if (conn == nullptr) return;
+    state->ws_retiring = nullptr;
+    if (state->ws_retire_id != 0) {
+        g_source_remove(state->ws_retire_id);
+        state->ws_retire_id = 0;
+    }
+    g_signal_handlers_disconnect_by_data(conn, state);
+    if (soup_websocket_connection_get_state(conn) ==
+        SOUP_WEBSOCKET_STATE_OPEN) {
+        soup_websocket_connection_close(conn, SOUP_WEBSOCKET_CLOSE_NORMAL,
+                                        nullptr);
+    }
+    g_object_unref(conn);
+
+    std::string held = std::move(state->ws_held_text);
+    state->ws_held_text.clear();
+    if (state->ws_rotate_overlapped) {
+        state->ws_rotate_overlapped = false;
+        state->ws_dedupe = true;
+        state->ws_dedupe_text.clear();
+        state->ws_dedupe_id =
+            g_timeout_add(WS_DEDUPE_TIMEOUT_MS, on_dedupe_timeout, state);
+        if (!held.empty()) ws_receive_text(state, held.c_str());
+    } else {
+        ws_emit_text(state, held);
+    }
+}
+
+static gboolean on_retire_timeout(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    state->ws_retire_id = 0;
+    ws_retire_finish(state);
+    return G_SOURCE_REMOVE;
+}
+
+// Wait for the old session to go quiet, within WS_ROTATE_DRAIN_MAX_MS
+static void ws_retire_wait(AppState *state) {
+    if (state->ws_retire_id != 0) g_source_remove(state->ws_retire_id);
+    gint64 left_ms = WS_ROTATE_DRAIN_MAX_MS -
+                     (g_get_monotonic_time() - state->ws_retire_started_us) /
+                         1000;
+    guint wait = static_cast<guint>(
+        std::clamp<gint64>(left_ms, 0, WS_ROTATE_QUIET_MS));
+    state->ws_retire_id = g_timeout_add(wait, on_retire_timeout, state);
+}
+
+static void on_retiring_message(SoupWebsocketConnection * /*conn*/,
+                                gint /*type*/, GBytes *message,
+                                gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+
+    gsize len = 0;
+    const char *data = static_cast<const char *>(
+        g_bytes_get_data(message, &len));
+    JsonParser *parser = json_parser_new();
+    if (!json_parser_load_from_data(parser, data, static_cast<gssize>(len),
+                                     nullptr)) {
+        g_object_unref(parser);
+        return;
+    }
+    JsonObject *obj = json_node_get_object(json_parser_get_root(parser));
+    const char *msg_type = json_object_get_string_member(obj, "type");
+
+    if (g_strcmp0(msg_type, "transcription.text.delta") == 0) {
         if (json_object_has_member(obj, "text")) {
             const char *text = json_object_get_string_member(obj, "text");
-            if (text != nullptr) {
-                if (state->dictating) {
-                    type_text(state, text);
-                } else {
-                    state->live_transcription += text;
-                    if (state->live_transcription_view != nullptr) {
-                        GtkTextBuffer *buf = gtk_text_view_get_buffer(
-                            GTK_TEXT_VIEW(state->live_transcription_view));
-                        gtk_text_buffer_set_text(
-                            buf, state->live_transcription.c_str(), -1);
-                        scroll_transcription_to_bottom(state);
-                    }
-                    // Append delta to temp file for crash safety
-                    if (!state->live_transcription_tmp_path.empty()) {
-                        std::ofstream tmp(state->live_transcription_tmp_path,
-                                          std::ios::app);
-                        if (tmp) {
-                            tmp << text;
-                        }
-                    }
-                }
-            }
+            if (text != nullptr) ws_emit_text(state, text);
         }
-
+        ws_retire_wait(state);
     } else if (g_strcmp0(msg_type, "error") == 0) {
-        const char *detail = "";
-        if (json_object_has_member(obj, "message")) {
-            detail = json_object_get_string_member(obj, "message");
-        }
-        g_warning("WebSocket transcription error: %s", detail);
-        ws_disconnect(state);
+        ws_retire_finish(state);
     }
-
     g_object_unref(parser);
 }
 
-static void on_ws_closed(SoupWebsocketConnection * /*conn*/,
-                         gpointer userdata) {
+static void on_retiring_closed(SoupWebsocketConnection *conn,
+                               gpointer userdata) {
     auto *state = static_cast<AppState *>(userdata);
-    if (state->ws_conn != nullptr) {
-        g_object_unref(state->ws_conn);
-        state->ws_conn = nullptr;
+    if (conn == state->ws_retiring) ws_retire_finish(state);
+}
+
+// Forced switches resend the last stretch of audio to the new session,
+// as backlog so the uplink budget doesn't shed it
+static void ws_rotate_overlap(AppState *state) {
+    PrerollBuffer *p = &state->ws_retained.audio;
+    size_t want = WS_ROTATE_OVERLAP_MS * WS_SAMPLE_RATE / 1000;
+    size_t n = std::min(p->size, want) / VAD_FRAME_SAMPLES * VAD_FRAME_SAMPLES;
+    if (n == 0) return;
+
+    gint64 now = g_get_monotonic_time();
+    size_t cap = p->buf.size();
+    for (size_t off = p->size - n; off + VAD_FRAME_SAMPLES <= p->size;
+         off += VAD_FRAME_SAMPLES) {
+        uplink_push(&state->ws_queue,
+                    p->buf.data() + (p->start + off) % cap, true, true, now);
+    }
+    state->ws_rotate_overlapped = !state->ws_recent_text.empty();
+}
+
+static void ws_rotate_switch(AppState *state, bool forced) {
+    ws_flush_uplink(state);
+    ws_dedupe_finish(state);
+
+    SoupWebsocketConnection *old = state->ws_conn;
+    g_signal_handlers_disconnect_by_data(old, state);
+    g_signal_connect(old, "message", G_CALLBACK(on_retiring_message), state);
+    g_signal_connect(old, "closed", G_CALLBACK(on_retiring_closed), state);
+    state->ws_retiring = old;
+    state->ws_retire_started_us = g_get_monotonic_time();
+    state->ws_held_text.clear();
+    ws_retire_wait(state);
+
+    SoupWebsocketConnection *conn = state->ws_successor;
+    g_signal_handlers_disconnect_by_data(conn, state);
+    state->ws_successor = nullptr;
+    state->ws_successor_ready = false;
+    state->ws_conn = conn;
+    ws_track_socket(state);
+    g_signal_connect(conn, "message", G_CALLBACK(on_ws_message), state);
+    g_signal_connect(conn, "closed", G_CALLBACK(on_ws_closed), state);
+
+    state->ws_rotations++;
+    g_message("Rotated to realtime session %d%s", state->ws_rotations + 1,
+              forced ? " mid-speech, with overlap" : " at a pause");
+    if (forced) ws_rotate_overlap(state);
+    retain_reset(&state->ws_retained);
+    state->ws_session_started_us = g_get_monotonic_time();
+    ws_pump_uplink(state, true);
+}
+
+// Called as audio is sent: start, and finish, a rotation when it's due
+static void ws_rotate_tick(AppState *state) {
+    if (!state->ws_ready || state->ws_conn == nullptr ||
+        state->ws_reconnecting || state->ws_retiring != nullptr)
+        return;
+    gint64 now = g_get_monotonic_time();
+    if (now - state->ws_session_started_us <
+        WS_ROTATE_AFTER_SECONDS * G_USEC_PER_SEC)
+        return;
+
+    if (state->ws_successor == nullptr) {
+        if (!state->ws_successor_connecting &&
+            now >= state->ws_successor_retry_us) {
+            ws_successor_open(state);
+        }
+        return;
+    }
+    if (!state->ws_successor_ready) return;
+
+    bool pause = !state->vad.open && state->ws_queue.count == 0;
+    bool overdue = now - state->ws_successor_ready_us >=
+                   WS_ROTATE_MAX_WAIT_SECONDS * G_USEC_PER_SEC;
+    if (pause || overdue) ws_rotate_switch(state, !pause);
+}
+
+// Abandon a pending rotation; a draining session is closed at once
+static void ws_rotate_stop(AppState *state) {
+    ws_successor_drop(state);
+    state->ws_successor_retry_us = 0;
+    ws_retire_finish(state);
+}
+
+// --- Capture thread ---
+
+static constexpr guint CAPTURE_PUMP_INTERVAL_MS = 20;
+static constexpr size_t CAPTURE_RING_SECONDS = 2;
+static constexpr size_t CAPTURE_SCRATCH_SAMPLES = 4096;
+
+using SampleSink = void (*)(const int16_t *samples, size_t count,
+                            void *userdata);
+
+// Runs on the capture thread: copy the fragment out and return at once
+static void on_capture_read(pa_stream *s, size_t /*nbytes*/, void *userdata) {
+    auto *tap = static_cast<CaptureTap *>(userdata);
+
+    const void *data;
+    size_t length;
+
+    while (pa_stream_peek(s, &data, &length) >= 0 && length > 0) {
+        if (data != nullptr) {
+            const auto *samples = static_cast<const int16_t *>(data);
+            size_t count = length / sizeof(int16_t);
+            if (tap->buffered) {
+                ring_push(&tap->ring, samples, count);
+            }
+            if (tap->metered) {
+                meter_process(&tap->meter, samples, count);
+                meter_publish(&tap->meter, &tap->levels);
+            }
+        }
+        pa_stream_drop(s);
     }
-    state->ws_ready = false;
+}
 
-    // If dictating, stop gracefully
-    if (state->dictating) {
-        stop_dictation(state);
+// Runs on the capture thread: the main loop pump picks up the flag
+static void on_capture_state(pa_stream *s, void *userdata) {
+    auto *tap = static_cast<CaptureTap *>(userdata);
+    if (pa_stream_get_state(s) == PA_STREAM_FAILED) {
+        tap->failed.store(true, std::memory_order_release);
     }
 }
 
-static void on_ws_connect_complete(GObject *source, GAsyncResult *result,
-                                   gpointer userdata) {
-    auto *state = static_cast<AppState *>(userdata);
+// Create and connect a mono S16LE capture stream on the capture thread.
+// Fragments are ~50 ms regardless of rate.
+static bool open_capture(AppState *state, CaptureTap *tap, const char *name,
+                         uint32_t rate, const char *device) {
+    if (!state->capture_ready) return false;
 
-    GError *error = nullptr;
-    SoupWebsocketConnection *conn =
-        soup_session_websocket_connect_finish(SOUP_SESSION(source), result,
-                                              &error);
-    if (error != nullptr) {
-        g_warning("WebSocket connect failed: %s", error->message);
-        g_error_free(error);
-        if (state->dictating) {
-            stop_dictation(state);
+    if (tap->buffered) {
+        ring_init(&tap->ring, rate * CAPTURE_RING_SECONDS);
+    }
+    if (tap->metered) {
+        meter_init(&tap->meter, rate);
+        meter_reset(&tap->meter);
+        meter_publish(&tap->meter, &tap->levels);
+    }
+    tap->failed.store(false, std::memory_order_relaxed);
+
+    const pa_sample_spec spec = {
+        .format = PA_SAMPLE_S16LE,
+        .rate = rate,
+        .channels = NUM_CHANNELS,
+    };
+
+    pa_buffer_attr attr = {};
+    attr.maxlength = static_cast<uint32_t>(-1);
+    attr.tlength = static_cast<uint32_t>(-1);
+    attr.prebuf = static_cast<uint32_t>(-1);
+    attr.minreq = static_cast<uint32_t>(-1);
+    attr.fragsize = (rate / 20) * sizeof(int16_t); // ~50ms mono S16LE
+
+    pa_threaded_mainloop_lock(state->capture_ml);
+    tap->stream = pa_stream_new(state->capture_ctx, name, &spec, nullptr);
+    if (tap->stream != nullptr) {
+        pa_stream_set_read_callback(tap->stream, on_capture_read, tap);
+        pa_stream_set_state_callback(tap->stream, on_capture_state, tap);
+        if (pa_stream_connect_record(tap->stream, device, &attr,
+                                     PA_STREAM_ADJUST_LATENCY) < 0) {
+            pa_stream_unref(tap->stream);
+            tap->stream = nullptr;
         }
-        return;
     }
+    pa_threaded_mainloop_unlock(state->capture_ml);
 
-    state->ws_conn = conn;
-    g_signal_connect(conn, "message", G_CALLBACK(on_ws_message), state);
-    g_signal_connect(conn, "closed", G_CALLBACK(on_ws_closed), state);
+    return tap->stream != nullptr;
 }
 
-static void ws_connect(AppState *state) {
-    if (!state->transcription_available) return;
-    if (state->ws_conn != nullptr) return;
+static void close_capture(AppState *state, CaptureTap *tap) {
+    if (tap->stream == nullptr) return;
+
+    pa_threaded_mainloop_lock(state->capture_ml);
+    pa_stream_set_read_callback(tap->stream, nullptr, nullptr);
+    pa_stream_set_state_callback(tap->stream, nullptr, nullptr);
+    pa_stream_disconnect(tap->stream);
+    pa_stream_unref(tap->stream);
+    tap->stream = nullptr;
+    pa_threaded_mainloop_unlock(state->capture_ml);
+
+    uint64_t dropped = tap->ring.dropped.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+        g_warning("Capture ring overflowed: %ju samples dropped",
+                  static_cast<uintmax_t>(dropped));
+    }
+}
 
-    state->resample_phase = 0.0;
-    state->live_transcription.clear();
-    state->ws_ready = false;
+// Hand everything queued in the ring to `sink`, in order
+static void drain_capture(CaptureTap *tap, std::vector<int16_t> &scratch,
+                          SampleSink sink, void *userdata) {
+    if (scratch.size() < CAPTURE_SCRATCH_SAMPLES) {
+        scratch.resize(CAPTURE_SCRATCH_SAMPLES);
+    }
+    size_t n;
+    while ((n = ring_pop(&tap->ring, scratch.data(), scratch.size())) > 0) {
+        sink(scratch.data(), n, userdata);
+    }
+}
 
-    SoupMessage *msg = soup_message_new(
-        "GET",
-        "wss://api.mistral.ai/v1/audio/transcriptions/realtime"
-        "?model=voxtral-mini-transcribe-realtime-2602");
+static const char *selected_device(AppState *state) {
+    return state->audio_device.empty() ? nullptr
+                                       : state->audio_device.c_str();
+}
 
-    SoupMessageHeaders *headers = soup_message_get_request_headers(msg);
-    std::string auth = "Bearer " + state->api_key;
-    soup_message_headers_replace(headers, "Authorization", auth.c_str());
+// --- Recording stream consumers ---
 
-    soup_session_websocket_connect_async(state->soup_session, msg, nullptr,
-                                         nullptr, G_PRIORITY_DEFAULT, nullptr,
-                                         on_ws_connect_complete, state);
-    g_object_unref(msg);
-}
+static constexpr size_t RECORDING_FLUSH_SAMPLES = 4 * AUDIO_BLOCK_SAMPLES;
 
-static void ws_disconnect(AppState *state) {
-    state->ws_ready = false;
-    if (state->ws_conn != nullptr &&
-        soup_websocket_connection_get_state(state->ws_conn) ==
-            SOUP_WEBSOCKET_STATE_OPEN) {
-        soup_websocket_connection_close(state->ws_conn,
-                                        SOUP_WEBSOCKET_CLOSE_NORMAL, nullptr);
+static void flush_recording(AppState *state) {
+    if (!wav_writer_flush(&state->recording_file,
+                          &state->recording_pending) &&
+        !state->recording_write_error) {
+        g_warning("Failed to write recording to %s: %s",
+                  state->recording_file.path.c_str(), g_strerror(errno));
+        state->recording_write_error = true;
     }
 }
 
-static void ws_send_audio(AppState *state, const int16_t *samples,
-                          size_t count) {
-    if (!state->ws_ready || state->ws_conn == nullptr) return;
+// Fall back to resampling the archive tap for the live transcript
+static void enable_live_resample(AppState *state) {
+    if (state->live_resampler.dot == nullptr) {
+        resampler_init(&state->live_resampler, SAMPLE_RATE, WS_SAMPLE_RATE);
+    }
+    resampler_reset(&state->live_resampler);
+    state->live_resample = true;
+}
 
-    std::vector<int16_t> resampled =
-        resample_44100_to_16000(samples, count, &state->resample_phase);
+static void on_archive_samples(const int16_t *samples, size_t num_samples,
+                               void *userdata) {
+    auto *state = static_cast<AppState *>(userdata);
 
-    if (resampled.empty()) return;
+    audio_store_append(&state->recording_pending, samples, num_samples);
+    if (state->recording_pending.size >= RECORDING_FLUSH_SAMPLES) {
+        flush_recording(state);
+    }
 
-    gchar *b64 = g_base64_encode(
-        reinterpret_cast<const guchar *>(resampled.data()),
-        resampled.size() * sizeof(int16_t));
+    if (state->live_resample) {
+        state->live_resample_buf.resize(resampler_max_output(
+            &state->live_resampler, num_samples));
+        size_t n = resampler_process(
+            &state->live_resampler, samples, num_samples,
+            state->live_resample_buf.data(),
+            state->live_resample_buf.size());
+        ws_send_audio(state, state->live_resample_buf.data(), n);
+    }
+}
 
-    gchar *json = g_strdup_printf(
-        "{\"type\":\"input_audio.append\",\"audio\":\"%s\"}", b64);
+// 16 kHz audio for the realtime WebSocket (live tap or dictation stream)
+static void on_live_samples(const int16_t *samples, size_t num_samples,
+                            void *userdata) {
+    ws_send_audio(static_cast<AppState *>(userdata), samples, num_samples);
+}
 
-    soup_websocket_connection_send_text(state->ws_conn, json);
+// Pulls the capture meter once per frame while recording or dictating.
+// Tick callbacks only run while the window is mapped, so a hidden window
+// costs nothing.
+static gboolean on_level_tick(GtkWidget *widget, GdkFrameClock * /*clock*/,
+                              gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    if (!state->recording && !state->dictating) {
+        gtk_level_bar_set_value(GTK_LEVEL_BAR(widget), 0.0);
+        state->level_tick_id = 0;
+        return G_SOURCE_REMOVE;
+    }
 
-    g_free(json);
-    g_free(b64);
+    double level = state->capture.levels.display.load(
+        std::memory_order_relaxed);
+    if (std::fabs(level - gtk_level_bar_get_value(GTK_LEVEL_BAR(widget))) >
+        1e-3) {
+        gtk_level_bar_set_value(GTK_LEVEL_BAR(widget), level);
+    }
+    return G_SOURCE_CONTINUE;
 }
 
-// --- Recording stream callbacks ---
+static void start_level_tick(AppState *state) {
+    if (state->level_tick_id == 0) {
+        state->level_tick_id = gtk_widget_add_tick_callback(
+            state->level_bar, on_level_tick, state, nullptr);
+    }
+}
 
-static void on_stream_read(pa_stream *s, size_t /*nbytes*/, void *userdata) {
-    auto *state = static_cast<AppState *>(userdata);
+static void log_meter_summary(const char *what, const LevelMeter *m) {
+    if (m->clipped > 0) {
+        g_message("%s: %" G_GUINT64_FORMAT " samples clipped "
+                   "(last short-term loudness %.1f LUFS)",
+                   what, m->clipped, m->lufs);
+    }
+}
 
-    const void *data;
-    size_t length;
+static void on_archive_failed(AppState *state) {
+    g_warning("PulseAudio stream failed: %s",
+              pa_strerror(pa_context_errno(state->capture_ctx)));
+    close_capture(state, &state->capture);
+    close_capture(state, &state->live_capture);
+    ws_disconnect(state);
+    state->recording = false;
+    gtk_button_set_label(GTK_BUTTON(state->record_button), "Record");
+    gtk_label_set_text(GTK_LABEL(state->label), "Stream error");
+    gtk_level_bar_set_value(GTK_LEVEL_BAR(state->level_bar), 0.0);
+}
 
-    while (pa_stream_peek(s, &data, &length) >= 0 && length > 0) {
-        if (data != nullptr) {
-            auto num_samples = length / sizeof(int16_t);
-            auto *samples = static_cast<const int16_t *>(data);
-            state->audio_buffer.insert(state->audio_buffer.end(),
-                                       samples, samples + num_samples);
+// Drains the capture rings on the main loop at a fixed cadence, so audio
+// keeps flowing into the rings even while the UI is busy
+static gboolean on_capture_pump(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
 
-            ws_send_audio(state, samples, num_samples);
+    if (state->recording) {
+        drain_capture(&state->capture, state->capture_scratch,
+                      on_archive_samples, state);
+        drain_capture(&state->live_capture, state->capture_scratch,
+                      on_live_samples, state);
+
+        if (state->live_capture.failed.exchange(false)) {
+            // Keep the live transcript going off the archive tap instead
+            g_warning("Live transcription stream failed: %s — resampling "
+                      "in-process",
+                      pa_strerror(pa_context_errno(state->capture_ctx)));
+            close_capture(state, &state->live_capture);
+            enable_live_resample(state);
+        }
+        if (state->capture.failed.exchange(false)) {
+            on_archive_failed(state);
+        }
+    } else if (state->dictating) {
+        drain_capture(&state->capture, state->capture_scratch,
+                      on_live_samples, state);
 
-            double peak = calculate_peak_level(samples, num_samples);
-            if (peak >= state->current_level) {
-                state->current_level = peak;
-            } else {
-                state->current_level = state->current_level * DECAY_FACTOR +
-                                       peak * (1.0 - DECAY_FACTOR);
-            }
-            gtk_level_bar_set_value(GTK_LEVEL_BAR(state->level_bar),
-                                    state->current_level);
+        if (state->capture.failed.exchange(false)) {
+            g_warning("Dictation PulseAudio stream failed: %s",
+                      pa_strerror(pa_context_errno(state->capture_ctx)));
+            stop_dictation(state);
         }
-        pa_stream_drop(s);
     }
+
+    if (!state->recording && !state->dictating) {
+        state->capture_pump_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
 }
 
-static void on_stream_state(pa_stream *s, void *userdata) {
-    auto *state = static_cast<AppState *>(userdata);
+static void start_capture_pump(AppState *state) {
+    if (state->capture_pump_id == 0) {
+        state->capture_pump_id = g_timeout_add(CAPTURE_PUMP_INTERVAL_MS,
+                                               on_capture_pump, state);
+    }
+}
 
-    if (pa_stream_get_state(s) == PA_STREAM_FAILED) {
-        g_warning("PulseAudio stream failed: %s",
-                  pa_strerror(pa_context_errno(state->pa_ctx)));
-        state->recording = false;
-        gtk_button_set_label(GTK_BUTTON(state->record_button), "Record");
-        gtk_label_set_text(GTK_LABEL(state->label), "Stream error");
-        gtk_level_bar_set_value(GTK_LEVEL_BAR(state->level_bar), 0.0);
-        state->current_level = 0.0;
+static void stop_capture_pump(AppState *state) {
+    if (state->capture_pump_id != 0) {
+        g_source_remove(state->capture_pump_id);
+        state->capture_pump_id = 0;
     }
 }
 
 // --- Recording control ---
 
-static void start_recording(AppState *state) {
-    static const pa_sample_spec spec = {
-        .format = PA_SAMPLE_S16LE,
-        .rate = SAMPLE_RATE,
-        .channels = NUM_CHANNELS,
-    };
+static std::string get_recording_tmp_path(AppState *state) {
+    return state->data_dir + "/.recording_in_progress.wav.partial";
+}
 
-    state->stream = pa_stream_new(state->pa_ctx, "linscribe-record",
-                                     &spec, nullptr);
-    if (state->stream == nullptr) {
-        gtk_label_set_text(GTK_LABEL(state->label), "Failed to create stream");
+static std::string get_transcript_journal_path(AppState *state) {
+    return state->data_dir + "/.transcription_in_progress.txt.partial";
+}
+
+static void start_recording(AppState *state) {
+    // Audio goes straight to disk, so memory stays flat however long the
+    // recording runs
+    if (!wav_writer_open(&state->recording_file,
+                         get_recording_tmp_path(state), SAMPLE_RATE)) {
+        gtk_label_set_text(GTK_LABEL(state->label),
+                           "Failed to create recording file");
         return;
     }
+    state->recording_write_error = false;
 
-    pa_stream_set_read_callback(state->stream, on_stream_read, state);
-    pa_stream_set_state_callback(state->stream, on_stream_state, state);
-
-    pa_buffer_attr attr = {};
-    attr.maxlength = static_cast<uint32_t>(-1);
-    attr.tlength = static_cast<uint32_t>(-1);
-    attr.prebuf = static_cast<uint32_t>(-1);
-    attr.minreq = static_cast<uint32_t>(-1);
-    attr.fragsize = 4410 * sizeof(int16_t); // ~50ms at 44100 Hz mono S16LE
-
-    const char *dev = state->audio_device.empty()
-                          ? nullptr
-                          : state->audio_device.c_str();
-    if (pa_stream_connect_record(state->stream, dev, &attr,
-                                 PA_STREAM_ADJUST_LATENCY) < 0) {
+    // Full-rate tap for the archived note
+    if (!open_capture(state, &state->capture, "linscribe-record",
+                      SAMPLE_RATE, selected_device(state))) {
         gtk_label_set_text(GTK_LABEL(state->label), "Failed to connect stream");
-        pa_stream_unref(state->stream);
-        state->stream = nullptr;
+        wav_writer_discard(&state->recording_file);
         return;
     }
 
-    state->audio_buffer.clear();
-    state->current_level = 0.0;
+    // Separate 16 kHz tap for live transcription, only when it can be used
+    state->live_resample = false;
+    if (state->transcription_available) {
+        if (!open_capture(state, &state->live_capture,
+                          "linscribe-record-live", WS_SAMPLE_RATE,
+                          selected_device(state))) {
+            g_warning("Failed to connect live transcription stream — "
+                      "resampling in-process");
+            enable_live_resample(state);
+        }
+    }
+
     state->recording = true;
+    start_capture_pump(state);
+    start_level_tick(state);
     gtk_button_set_label(GTK_BUTTON(state->record_button), "Stop");
     gtk_label_set_text(GTK_LABEL(state->label), "Recording...");
 
     // Start real-time transcription
     state->live_transcription.clear();
-    state->resample_phase = 0.0;
-    if (state->live_transcription_view != nullptr) {
-        GtkTextBuffer *buf = gtk_text_view_get_buffer(
-            GTK_TEXT_VIEW(state->live_transcription_view));
-        gtk_text_buffer_set_text(buf, "", -1);
-    }
+    live_view_clear(state);
     if (state->live_transcription_scroll != nullptr) {
         gtk_widget_set_no_show_all(state->live_transcription_scroll, FALSE);
         gtk_widget_show_all(state->live_transcription_scroll);
     }
 
-    // Set up temp file for crash-safe incremental writes
-    state->live_transcription_tmp_path =
-        state->data_dir + "/.transcription_in_progress.txt.partial";
-    { std::ofstream(state->live_transcription_tmp_path, std::ios::trunc); }
+    // Set up the journal for crash-safe incremental writes
+    state->live_transcription_tmp_path = get_transcript_journal_path(state);
+    if (!journal_open(&state->journal, state->live_transcription_tmp_path,
+                      state->journal_sync_ms, state->journal_sync_bytes)) {
+        g_warning("Failed to create transcript journal %s",
+                  state->live_transcription_tmp_path.c_str());
+    }
 
     ws_connect(state);
 }
 
 static void stop_recording(AppState *state) {
-    if (state->stream != nullptr) {
-        pa_stream_disconnect(state->stream);
-        pa_stream_unref(state->stream);
-        state->stream = nullptr;
-    }
+    close_capture(state, &state->capture);
+    close_capture(state, &state->live_capture);
+
+    // Pick up whatever the capture thread queued before the streams closed
+    drain_capture(&state->capture, state->capture_scratch,
+                  on_archive_samples, state);
+    stop_capture_pump(state);
+    flush_recording(state);
 
     ws_disconnect(state);
+    journal_close(&state->journal);
+
+    if (!wav_writer_finish(&state->recording_file)) {
+        g_warning("Failed to finalize recording %s",
+                  state->recording_file.path.c_str());
+    }
 
     state->recording = false;
-    state->current_level = 0.0;
+    log_meter_summary("Recording", &state->capture.meter);
     gtk_level_bar_set_value(GTK_LEVEL_BAR(state->level_bar), 0.0);
     gtk_button_set_label(GTK_BUTTON(state->record_button), "Record");
 
     double seconds =
-        static_cast<double>(state->audio_buffer.size()) / SAMPLE_RATE;
+        static_cast<double>(state->recording_file.data_bytes /
+                            sizeof(int16_t)) / SAMPLE_RATE;
     char buf[64];
     g_snprintf(buf, sizeof(buf), "Recorded %.1f seconds - save?", seconds);
     gtk_label_set_text(GTK_LABEL(state->label), buf);
@@ -786,18 +5084,25 @@ static void stop_recording(AppState *state) {
 static void on_save_clicked(GtkWidget * /*button*/, gpointer userdata) {
     auto *state = static_cast<AppState *>(userdata);
 
-    if (state->audio_buffer.empty()) {
+    if (state->recording_file.data_bytes == 0) {
+        wav_writer_discard(&state->recording_file);
         gtk_label_set_text(GTK_LABEL(state->label), "Nothing to save");
         gtk_widget_hide(state->save_discard_box);
         gtk_widget_set_no_show_all(state->save_discard_box, TRUE);
         return;
     }
 
+    // The audio is already on disk — saving is just a rename
     std::string path = generate_note_filename(state->data_dir);
-    if (!write_wav_file(path, state->audio_buffer)) {
+    std::error_code ec;
+    std::filesystem::rename(state->recording_file.path, path, ec);
+    if (ec) {
+        g_warning("Failed to save recording: %s", ec.message().c_str());
         gtk_label_set_text(GTK_LABEL(state->label), "Failed to save");
         return;
     }
+    state->recording_file.path.clear();
+    state->recording_file.data_bytes = 0;
 
     // Write live transcription as .txt sidecar
     if (!state->live_transcription.empty()) {
@@ -809,7 +5114,6 @@ static void on_save_clicked(GtkWidget * /*button*/, gpointer userdata) {
         }
     }
 
-    state->audio_buffer.clear();
     state->live_transcription.clear();
     if (state->live_transcription_scroll != nullptr) {
         gtk_widget_hide(state->live_transcription_scroll);
@@ -827,6 +5131,7 @@ static void on_save_clicked(GtkWidget * /*button*/, gpointer userdata) {
 
     load_notes(state);
     refresh_notes_list(state);
+    encode_note_async(state, path);
 
     gtk_label_set_text(GTK_LABEL(state->label), "Note saved");
 }
@@ -834,7 +5139,7 @@ static void on_save_clicked(GtkWidget * /*button*/, gpointer userdata) {
 static void on_discard_clicked(GtkWidget * /*button*/, gpointer userdata) {
     auto *state = static_cast<AppState *>(userdata);
 
-    state->audio_buffer.clear();
+    wav_writer_discard(&state->recording_file);
     state->live_transcription.clear();
     if (state->live_transcription_scroll != nullptr) {
         gtk_widget_hide(state->live_transcription_scroll);
@@ -884,8 +5189,11 @@ static void on_delete_clicked(GtkWidget *button, gpointer userdata) {
         stop_playback(state);
     }
 
-    const std::string &filepath =
-        state->notes[static_cast<size_t>(note_index)].filepath;
+    // Drop its queued requests and abandon any in flight
+    const VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
+    std::string filepath = note.filepath;
+    api_cancel_note(state, note.id);
+
     std::filesystem::remove(filepath);
 
     // Also delete the .txt sidecar if it exists
@@ -898,190 +5206,571 @@ static void on_delete_clicked(GtkWidget *button, gpointer userdata) {
     diarized_path.replace_extension(".diarized.txt");
     std::filesystem::remove(diarized_path);
 
+    // And the prepared upload, if any
+    std::filesystem::remove(upload_cache_path(filepath));
+
     load_notes(state);
     refresh_notes_list(state);
 
     gtk_label_set_text(GTK_LABEL(state->label), "Note deleted");
 }
 
-// --- Transcription ---
+// --- Transcription ---
+
+static gboolean on_notes_refresh(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    state->notes_refresh_id = 0;
+    refresh_notes_list(state);
+    return G_SOURCE_REMOVE;
+}
+
+// Rebuild the list once per main loop pass, however many results arrive
+static void queue_notes_refresh(AppState *state) {
+    if (state->notes_refresh_id != 0) return;
+    state->notes_refresh_id = g_idle_add(on_notes_refresh, state);
+}
+
+// "Transcription complete", plus how many are still queued
+static void set_job_status(AppState *state, const char *done,
+                           ApiEndpoint endpoint) {
+    size_t queued = api_pending_count(state, endpoint);
+    if (queued == 0) {
+        gtk_label_set_text(GTK_LABEL(state->label), done);
+        return;
+    }
+    char buf[128];
+    g_snprintf(buf, sizeof(buf), "%s — %zu queued", done, queued);
+    gtk_label_set_text(GTK_LABEL(state->label), buf);
+}
+
+static void on_transcribe_done(AppState *state, ApiJob *job,
+                               GBytes *response_bytes, const char *error_msg) {
+    // The note may have been deleted while the request was queued
+    int note_index = find_note(state, job->note_id);
+    if (note_index < 0) return;
+
+    VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
+    note.transcribing = false;
+    queue_notes_refresh(state);
+    if (api_job_cancelled(job)) return;
+
+    if (response_bytes == nullptr) {
+        char status_buf[256];
+        g_snprintf(status_buf, sizeof(status_buf), "Transcription failed: %s",
+                   error_msg);
+        gtk_label_set_text(GTK_LABEL(state->label), status_buf);
+        return;
+    }
+
+    GError *error = nullptr;
+    gsize response_len = 0;
+    const char *response_data =
+        static_cast<const char *>(g_bytes_get_data(response_bytes, &response_len));
+
+    // Parse JSON response
+    JsonParser *parser = json_parser_new();
+    if (!json_parser_load_from_data(parser, response_data,
+                                     static_cast<gssize>(response_len), &error)) {
+        gtk_label_set_text(GTK_LABEL(state->label), "Transcription failed: invalid response");
+        g_warning("JSON parse error: %s", error->message);
+        g_error_free(error);
+        g_object_unref(parser);
+        return;
+    }
+
+    JsonNode *root = json_parser_get_root(parser);
+    JsonObject *obj = json_node_get_object(root);
+
+    // Check for error responses
+    if (json_object_has_member(obj, "message")) {
+        const char *err_msg = json_object_get_string_member(obj, "message");
+        char status_buf[256];
+        g_snprintf(status_buf, sizeof(status_buf), "Transcription failed: %s", err_msg);
+        gtk_label_set_text(GTK_LABEL(state->label), status_buf);
+        g_object_unref(parser);
+        return;
+    }
+
+    if (!json_object_has_member(obj, "text")) {
+        gtk_label_set_text(GTK_LABEL(state->label), "Transcription failed: no text in response");
+        g_object_unref(parser);
+        return;
+    }
+
+    const char *text = json_object_get_string_member(obj, "text");
+    note.transcription = text;
+
+    // Save transcription to .txt sidecar
+    std::filesystem::path txt_path(note.filepath);
+    txt_path.replace_extension(".txt");
+    std::ofstream txt_file(txt_path);
+    if (txt_file) {
+        txt_file << note.transcription;
+    }
+
+    g_object_unref(parser);
+
+    set_job_status(state, "Transcription complete", ApiEndpoint::TRANSCRIBE);
+}
+
+// --- Long note transcription ---
+
+// Long notes are split at pauses into chunks of about CHUNK_TARGET_SECONDS,
+// transcribed concurrently and stitched back together in order.  Each
+// chunk starts slightly before its cut so no word is lost at the seam;
+// the repeated words are dropped when stitching.
+
+static constexpr double CHUNK_MIN_NOTE_SECONDS = 8 * 60.0;
+static constexpr double CHUNK_TARGET_SECONDS = 5 * 60.0;
+static constexpr double CHUNK_SEARCH_SECONDS = 30.0;  // either side of target
+static constexpr double CHUNK_OVERLAP_SECONDS = 1.0;
+static constexpr double CHUNK_FRAME_SECONDS = 0.1;
+static constexpr size_t CHUNK_PAUSE_FRAMES = 5;       // pause length scored
+static constexpr size_t STITCH_MAX_OVERLAP_WORDS = 12;
+
+struct ChunkSpan {
+    sf_count_t start;
+    sf_count_t frames;
+};
+
+// Pick cut points at the quietest stretch near each target boundary
+static std::vector<ChunkSpan> plan_chunks(const std::string &path) {
+    std::vector<ChunkSpan> plan;
+    AudioDecoder dec;
+    if (!audio_decoder_open(&dec, path)) return plan;
+
+    auto frame_len = static_cast<size_t>(
+        std::max(1.0, dec.info.samplerate * CHUNK_FRAME_SECONDS));
+    sf_count_t total_samples = dec.info.frames;
+
+    // Running sum of per-frame mean energy, for windowed averages
+    std::vector<double> energy_sum(1, 0.0);
+    std::vector<int16_t> buf(frame_len);
+    size_t n;
+    while ((n = audio_decoder_read(&dec, buf.data(), frame_len)) > 0) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            sum += static_cast<double>(buf[i]) * buf[i];
+        }
+        energy_sum.push_back(energy_sum.back() + sum / static_cast<double>(n));
+    }
+    audio_decoder_close(&dec);
+
+    size_t total = energy_sum.size() - 1;
+    auto pause_energy = [&](size_t f) {
+        size_t a = f >= CHUNK_PAUSE_FRAMES / 2 ? f - CHUNK_PAUSE_FRAMES / 2 : 0;
+        size_t b = std::min(total, a + CHUNK_PAUSE_FRAMES);
+        return (energy_sum[b] - energy_sum[a]) /
+               static_cast<double>(std::max<size_t>(1, b - a));
+    };
+
+    auto target = static_cast<size_t>(CHUNK_TARGET_SECONDS / CHUNK_FRAME_SECONDS);
+    auto search = static_cast<size_t>(CHUNK_SEARCH_SECONDS / CHUNK_FRAME_SECONDS);
+    auto overlap = static_cast<sf_count_t>(
+        CHUNK_OVERLAP_SECONDS * static_cast<double>(frame_len) /
+        CHUNK_FRAME_SECONDS);
+
+    std::vector<sf_count_t> cuts;
+    size_t prev = 0;
+    while (total - prev > target + search) {
+        size_t best = prev + target - search;
+        for (size_t f = best + 1; f <= prev + target + search; f++) {
+            if (pause_energy(f) < pause_energy(best)) best = f;
+        }
+        cuts.push_back(static_cast<sf_count_t>(best * frame_len));
+        prev = best;
+    }
+    cuts.push_back(total_samples);
+
+    sf_count_t start = 0;
+    for (sf_count_t cut : cuts) {
+        sf_count_t from = std::max<sf_count_t>(0, start - overlap);
+        plan.push_back({from, cut - from});
+        start = cut;
+    }
+    return plan;
+}
+
+static std::string normalize_word(const std::string &word) {
+    std::string out;
+    for (char c : word) {
+        auto u = static_cast<unsigned char>(c);
+        if (u >= 0x80 || g_ascii_isalnum(c)) {
+            out += g_ascii_tolower(c);
+        }
+    }
+    return out;
+}
+
+// Word start/end byte offsets of `text`
+static std::vector<std::pair<size_t, size_t>> word_spans(
+    const std::string &text) {
+    std::vector<std::pair<size_t, size_t>> spans;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && g_ascii_isspace(text[i])) i++;
+        size_t begin = i;
+        while (i < text.size() && !g_ascii_isspace(text[i])) i++;
+        if (i > begin) spans.emplace_back(begin, i);
+    }
+    return spans;
+}
+
+// Append `next` to `stitched`, dropping words already at the end of it
+static void stitch_append(std::string &stitched, const std::string &next) {
+    auto next_words = word_spans(next);
+    if (next_words.empty()) return;
+    if (stitched.empty()) {
+        stitched = next.substr(next_words.front().first);
+        return;
+    }
+
+    auto have_words = word_spans(stitched);
+    size_t max_k = std::min({STITCH_MAX_OVERLAP_WORDS, have_words.size(),
+                             next_words.size()});
+    size_t skip = 0;
+    for (size_t k = max_k; k > 0 && skip == 0; k--) {
+        bool match = true;
+        for (size_t j = 0; j < k && match; j++) {
+            const auto &a = have_words[have_words.size() - k + j];
+            const auto &b = next_words[j];
+            std::string wa = normalize_word(stitched.substr(a.first, a.second - a.first));
+            match = !wa.empty() &&
+                    wa == normalize_word(next.substr(b.first, b.second - b.first));
+        }
+        if (match) skip = k;
+    }
+    if (skip == next_words.size()) return;
+
+    stitched += ' ';
+    stitched += next.substr(next_words[skip].first);
+}
+
+struct ChunkedTranscription {
+    AppState *state;
+    std::string note_id;
+    ApiPriority priority;
+    std::string source;     // prepared upload, or the note itself
+    std::vector<ChunkSpan> chunks;
+    std::vector<std::string> texts;
+    std::vector<bool> done;
+    size_t pending = 0;     // parts submitted and not yet finished
+    size_t completed = 0;
+    bool failed = false;
+    bool cancelled = false;
+};
+
+static void chunk_job_finish(ChunkedTranscription *job) {
+    AppState *state = job->state;
+    int note_index = find_note(state, job->note_id);
+    if (note_index >= 0) {
+        VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
+        note.transcribing = false;
+        if (job->failed || job->cancelled) {
+            note.transcription.clear();
+        } else {
+            std::filesystem::path txt_path(note.filepath);
+            txt_path.replace_extension(".txt");
+            std::ofstream txt_file(txt_path);
+            if (txt_file) {
+                txt_file << note.transcription;
+            }
+        }
+        if (job->failed) {
+            gtk_label_set_text(GTK_LABEL(state->label),
+                               "Transcription failed");
+        } else if (!job->cancelled) {
+            set_job_status(state, "Transcription complete",
+                           ApiEndpoint::TRANSCRIBE);
+        }
+        queue_notes_refresh(state);
+    }
+    delete job;
+}
+
+// Record one part's outcome and show the in-order prefix so far
+static void chunk_finished(ChunkedTranscription *job, size_t index,
+                           const char *text, bool cancelled) {
+    AppState *state = job->state;
+    job->pending--;
+    if (text != nullptr) {
+        job->texts[index] = text;
+        job->done[index] = true;
+        job->completed++;
+    } else if (cancelled) {
+        job->cancelled = true;
+    } else if (!job->failed) {
+        // No point sending the rest.  Queued parts finish right here, so
+        // hold the job open until they have.
+        job->failed = true;
+        job->pending++;
+        api_cancel_group(state, job);
+        job->pending--;
+    }
 
-static void on_transcribe_response(GObject *source, GAsyncResult *result,
-                                   gpointer userdata) {
-    auto *data = static_cast<TranscribeCallbackData *>(userdata);
-    AppState *state = data->state;
-    int note_index = data->note_index;
-    delete data;
+    int note_index = find_note(state, job->note_id);
+    if (note_index >= 0 && !job->failed && !job->cancelled) {
+        VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
+        note.transcription.clear();
+        for (size_t i = 0; i < job->chunks.size() && job->done[i]; i++) {
+            stitch_append(note.transcription, job->texts[i]);
+        }
+        char buf[96];
+        g_snprintf(buf, sizeof(buf), "Transcribing... %zu/%zu parts",
+                   job->completed, job->chunks.size());
+        gtk_label_set_text(GTK_LABEL(state->label), buf);
+        queue_notes_refresh(state);
+    }
 
-    GError *error = nullptr;
-    GBytes *response_bytes = soup_session_send_and_read_finish(
-        SOUP_SESSION(source), result, &error);
+    if (job->pending == 0) chunk_job_finish(job);
+}
 
-    // Validate note_index is still in range (notes may have been deleted)
-    if (note_index < 0 ||
-        note_index >= static_cast<int>(state->notes.size())) {
-        if (response_bytes) g_bytes_unref(response_bytes);
-        if (error) g_error_free(error);
+static void on_chunk_done(AppState * /*state*/, ApiJob *api_job,
+                          GBytes *response_bytes, const char *error_msg) {
+    auto *job = static_cast<ChunkedTranscription *>(api_job->userdata);
+    size_t index = api_job->part;
+    if (api_job_cancelled(api_job)) {
+        chunk_finished(job, index, nullptr, true);
         return;
     }
-
-    VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
-    note.transcribing = false;
-
-    if (error != nullptr) {
-        gtk_label_set_text(GTK_LABEL(state->label), "Transcription failed: network error");
-        g_warning("Transcription error: %s", error->message);
-        g_error_free(error);
-        refresh_notes_list(state);
+    if (response_bytes == nullptr) {
+        g_warning("Transcription of part %zu failed: %s", index + 1,
+                  error_msg);
+        chunk_finished(job, index, nullptr, false);
         return;
     }
 
-    // Check HTTP status from the message — retrieve from session's last message
-    // We need to get the status code from the response bytes content
-    gsize response_len = 0;
-    const char *response_data =
-        static_cast<const char *>(g_bytes_get_data(response_bytes, &response_len));
-
-    // Parse JSON response
+    gsize len = 0;
+    const char *data =
+        static_cast<const char *>(g_bytes_get_data(response_bytes, &len));
     JsonParser *parser = json_parser_new();
-    if (!json_parser_load_from_data(parser, response_data,
-                                     static_cast<gssize>(response_len), &error)) {
-        gtk_label_set_text(GTK_LABEL(state->label), "Transcription failed: invalid response");
-        g_warning("JSON parse error: %s", error->message);
-        g_error_free(error);
-        g_object_unref(parser);
-        g_bytes_unref(response_bytes);
-        refresh_notes_list(state);
-        return;
+    const char *text = nullptr;
+    if (json_parser_load_from_data(parser, data, static_cast<gssize>(len),
+                                   nullptr)) {
+        JsonObject *obj = json_node_get_object(json_parser_get_root(parser));
+        if (obj != nullptr && json_object_has_member(obj, "text")) {
+            text = json_object_get_string_member(obj, "text");
+        } else if (obj != nullptr && json_object_has_member(obj, "message")) {
+            g_warning("Transcription of part %zu failed: %s", index + 1,
+                      json_object_get_string_member(obj, "message"));
+        }
     }
+    chunk_finished(job, index, text, false);
+    g_object_unref(parser);
+}
 
-    JsonNode *root = json_parser_get_root(parser);
-    JsonObject *obj = json_node_get_object(root);
+static void encode_chunk_thread(GTask *task, gpointer /*source*/,
+                                gpointer task_data,
+                                GCancellable * /*cancellable*/) {
+    auto *api_job = static_cast<ApiJob *>(task_data);
+    auto *job = static_cast<ChunkedTranscription *>(api_job->userdata);
+    const ChunkSpan &span = job->chunks[api_job->part];
+    GBytes *bytes = encode_audio_range(job->source, span.start, span.frames,
+                                       codec_info(UPLOAD_CODEC),
+                                       UPLOAD_SAMPLE_RATE);
+    g_task_return_pointer(task, bytes,
+                          reinterpret_cast<GDestroyNotify>(g_bytes_unref));
+}
 
-    // Check for error responses
-    if (json_object_has_member(obj, "message")) {
-        const char *err_msg = json_object_get_string_member(obj, "message");
-        char status_buf[256];
-        g_snprintf(status_buf, sizeof(status_buf), "Transcription failed: %s", err_msg);
-        gtk_label_set_text(GTK_LABEL(state->label), status_buf);
-        g_object_unref(parser);
-        g_bytes_unref(response_bytes);
-        refresh_notes_list(state);
+static void on_chunk_encoded(GObject * /*source*/, GAsyncResult *result,
+                             gpointer userdata) {
+    auto *api_job = static_cast<ApiJob *>(userdata);
+    char filename[64];
+    g_snprintf(filename, sizeof(filename), "part_%03zu%s", api_job->part + 1,
+               codec_info(UPLOAD_CODEC)->extension);
+
+    UploadPayload payload;
+    payload.bytes = static_cast<GBytes *>(
+        g_task_propagate_pointer(G_TASK(result), nullptr));
+    payload.filename = filename;
+    payload.mime_type = codec_info(UPLOAD_CODEC)->mime_type;
+    api_job_prepared(api_job->state, api_job, payload);
+    if (payload.bytes != nullptr) g_bytes_unref(payload.bytes);
+}
+
+// Prepare step for one part: encode its span of the note
+static void prepare_chunk(AppState * /*state*/, ApiJob *api_job) {
+    GTask *task = g_task_new(nullptr, nullptr, on_chunk_encoded, api_job);
+    g_task_set_task_data(task, api_job, nullptr);
+    g_task_run_in_thread(task, encode_chunk_thread);
+    g_object_unref(task);
+}
+
+static void plan_chunks_thread(GTask *task, gpointer /*source*/,
+                               gpointer task_data,
+                               GCancellable * /*cancellable*/) {
+    auto *job = static_cast<ChunkedTranscription *>(task_data);
+    job->chunks = plan_chunks(job->source);
+    g_task_return_boolean(task, !job->chunks.empty());
+}
+
+static void submit_transcribe_job(AppState *state, const std::string &note_id,
+                                  ApiPriority priority) {
+    ApiJob *job = api_job_new(state, ApiEndpoint::TRANSCRIBE, priority,
+                              note_id);
+    job->prepare = api_prepare_note;
+    job->done = on_transcribe_done;
+    api_submit(state, job);
+}
+
+// Done step of the planning job: the parts go to the scheduler as jobs of
+// their own, or the note falls back to a single request
+static void on_chunks_planned(AppState *state, ApiJob *api_job,
+                              GBytes * /*response*/, const char *error) {
+    auto *job = static_cast<ChunkedTranscription *>(api_job->userdata);
+    int note_index = find_note(state, job->note_id);
+
+    if (api_job_cancelled(api_job)) {
+        if (note_index >= 0) {
+            state->notes[static_cast<size_t>(note_index)].transcribing = false;
+            queue_notes_refresh(state);
+        }
+        delete job;
         return;
     }
-
-    if (!json_object_has_member(obj, "text")) {
-        gtk_label_set_text(GTK_LABEL(state->label), "Transcription failed: no text in response");
-        g_object_unref(parser);
-        g_bytes_unref(response_bytes);
-        refresh_notes_list(state);
+    if (note_index < 0 || error != nullptr || job->chunks.size() < 2) {
+        // Deleted, unreadable, or too short to split after all
+        if (note_index >= 0) {
+            submit_transcribe_job(state, job->note_id, job->priority);
+        }
+        delete job;
         return;
     }
 
-    const char *text = json_object_get_string_member(obj, "text");
-    note.transcription = text;
+    job->texts.resize(job->chunks.size());
+    job->done.assign(job->chunks.size(), false);
+    job->pending = job->chunks.size();
+    char buf[96];
+    g_snprintf(buf, sizeof(buf), "Transcribing... 0/%zu parts",
+               job->chunks.size());
+    gtk_label_set_text(GTK_LABEL(state->label), buf);
 
-    // Save transcription to .txt sidecar
-    std::filesystem::path txt_path(note.filepath);
-    txt_path.replace_extension(".txt");
-    std::ofstream txt_file(txt_path);
-    if (txt_file) {
-        txt_file << note.transcription;
+    // The scheduler decides how many parts are in flight
+    for (size_t i = 0; i < job->chunks.size(); i++) {
+        ApiJob *part = api_job_new(state, ApiEndpoint::TRANSCRIBE,
+                                   job->priority, job->note_id);
+        part->prepare = prepare_chunk;
+        part->done = on_chunk_done;
+        part->userdata = job;
+        part->part = i;
+        api_submit(state, part);
     }
+}
 
-    g_object_unref(parser);
-    g_bytes_unref(response_bytes);
-
-    gtk_label_set_text(GTK_LABEL(state->label), "Transcription complete");
-    refresh_notes_list(state);
+static void on_chunks_plan_thread_done(GObject * /*source*/,
+                                       GAsyncResult *result,
+                                       gpointer userdata) {
+    auto *api_job = static_cast<ApiJob *>(userdata);
+    bool ok = g_task_propagate_boolean(G_TASK(result), nullptr);
+    api_job_complete(api_job->state, api_job, nullptr,
+                     ok ? nullptr : "could not split audio file");
 }
 
-static void transcribe_note(AppState *state, int note_index) {
-    if (note_index < 0 ||
-        note_index >= static_cast<int>(state->notes.size()))
+static void start_chunked_transcription(AppState *state, void *userdata,
+                                        const UploadPayload &payload) {
+    auto *api_job = static_cast<ApiJob *>(userdata);
+    auto *job = static_cast<ChunkedTranscription *>(api_job->userdata);
+    int note_index = find_note(state, job->note_id);
+    if (api_job_cancelled(api_job) || note_index < 0 ||
+        payload.bytes == nullptr) {
+        // on_chunks_planned() sorts out what follows
+        api_job_complete(state, api_job, nullptr, "could not read audio file");
         return;
+    }
 
-    VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
+    const VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
+    std::string cache = upload_cache_path(note.filepath);
+    job->source = std::filesystem::exists(cache) ? cache : note.filepath;
+
+    GTask *task = g_task_new(nullptr, nullptr, on_chunks_plan_thread_done,
+                             api_job);
+    g_task_set_task_data(task, job, nullptr);
+    g_task_run_in_thread(task, plan_chunks_thread);
+    g_object_unref(task);
+}
 
-    // Read WAV file into GBytes
-    GError *error = nullptr;
-    GMappedFile *mapped = g_mapped_file_new(note.filepath.c_str(), FALSE, &error);
-    if (mapped == nullptr) {
-        gtk_label_set_text(GTK_LABEL(state->label), "Failed to read audio file");
-        if (error) {
-            g_warning("File read error: %s", error->message);
-            g_error_free(error);
-        }
-        note.transcribing = false;
-        refresh_notes_list(state);
+// Prepare step of the planning job.  It sends nothing itself, so it ends
+// in api_job_complete() rather than api_job_prepared().
+static void prepare_chunk_plan(AppState *state, ApiJob *api_job) {
+    auto *job = static_cast<ChunkedTranscription *>(api_job->userdata);
+    int note_index = find_note(state, job->note_id);
+    if (note_index < 0) {
+        api_job_complete(state, api_job, nullptr, "note deleted");
         return;
     }
-    GBytes *file_bytes = g_mapped_file_get_bytes(mapped);
-    g_mapped_file_unref(mapped);
+    request_upload(state, note_index, start_chunked_transcription, api_job);
+}
 
-    // Build multipart form data
-    SoupMultipart *multipart = soup_multipart_new(SOUP_FORM_MIME_TYPE_MULTIPART);
-    soup_multipart_append_form_string(multipart, "model", "voxtral-mini-latest");
+static void transcribe_note(AppState *state, int note_index,
+                            ApiPriority priority) {
+    if (note_index < 0 ||
+        note_index >= static_cast<int>(state->notes.size()))
+        return;
+    const VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
 
-    // Extract filename from path
-    std::filesystem::path fp(note.filepath);
-    std::string filename = fp.filename().string();
-    soup_multipart_append_form_file(multipart, "file", filename.c_str(),
-                                     "audio/wav", file_bytes);
-    g_bytes_unref(file_bytes);
-
-    // Create message from multipart
-    SoupMessage *msg = soup_message_new_from_multipart(
-        "https://api.mistral.ai/v1/audio/transcriptions", multipart);
-    soup_multipart_free(multipart);
+    // Long notes go up in parallel parts rather than one slow request.
+    // Planning the parts is a scheduler job too, so cancelling the note
+    // or shutting down reaches it before any part exists.
+    if (note.duration_seconds >= CHUNK_MIN_NOTE_SECONDS) {
+        auto *job = new ChunkedTranscription{};
+        job->state = state;
+        job->note_id = note.id;
+        job->priority = priority;
+        ApiJob *plan = api_job_new(state, ApiEndpoint::TRANSCRIBE, priority,
+                                   note.id);
+        plan->prepare = prepare_chunk_plan;
+        plan->done = on_chunks_planned;
+        plan->userdata = job;
+        api_submit(state, plan);
+    } else {
+        submit_transcribe_job(state, note.id, priority);
+    }
+}
 
-    // Set authorization header
-    SoupMessageHeaders *headers = soup_message_get_request_headers(msg);
-    std::string auth = "Bearer " + state->api_key;
-    soup_message_headers_replace(headers, "Authorization", auth.c_str());
+// Queue every note without a transcription, behind anything interactive
+static void transcribe_all_pending(AppState *state) {
+    if (!state->transcription_available) return;
 
-    // Prepare callback data
-    auto *cb_data = new TranscribeCallbackData{state, note_index};
+    size_t queued = 0;
+    for (size_t i = 0; i < state->notes.size(); i++) {
+        VoiceNote &note = state->notes[i];
+        if (note.transcribing || !note.transcription.empty()) continue;
+        note.transcribing = true;
+        transcribe_note(state, static_cast<int>(i), ApiPriority::BULK);
+        queued++;
+    }
 
-    // Send async request
-    soup_session_send_and_read_async(state->soup_session, msg,
-                                      G_PRIORITY_DEFAULT, nullptr,
-                                      on_transcribe_response, cb_data);
-    g_object_unref(msg);
+    char buf[96];
+    if (queued == 0) {
+        g_snprintf(buf, sizeof(buf), "No notes waiting for transcription");
+    } else {
+        g_snprintf(buf, sizeof(buf), "Transcribing %zu notes...", queued);
+    }
+    gtk_label_set_text(GTK_LABEL(state->label), buf);
+    queue_notes_refresh(state);
 }
 
 // --- Diarization ---
 
-static void on_diarize_response(GObject *source, GAsyncResult *result,
-                                gpointer userdata) {
-    auto *data = static_cast<DiarizeCallbackData *>(userdata);
-    AppState *state = data->state;
-    int note_index = data->note_index;
-    delete data;
-
-    GError *error = nullptr;
-    GBytes *response_bytes = soup_session_send_and_read_finish(
-        SOUP_SESSION(source), result, &error);
-
-    if (note_index < 0 ||
-        note_index >= static_cast<int>(state->notes.size())) {
-        if (response_bytes) g_bytes_unref(response_bytes);
-        if (error) g_error_free(error);
-        return;
-    }
+static void on_diarize_done(AppState *state, ApiJob *job,
+                            GBytes *response_bytes, const char *error_msg) {
+    int note_index = find_note(state, job->note_id);
+    if (note_index < 0) return;
 
     VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
     note.diarizing = false;
+    queue_notes_refresh(state);
+    if (api_job_cancelled(job)) return;
 
-    if (error != nullptr) {
-        gtk_label_set_text(GTK_LABEL(state->label),
-                           "Diarization failed: network error");
-        g_warning("Diarization error: %s", error->message);
-        g_error_free(error);
-        refresh_notes_list(state);
+    if (response_bytes == nullptr) {
+        char status_buf[256];
+        g_snprintf(status_buf, sizeof(status_buf), "Diarization failed: %s",
+                   error_msg);
+        gtk_label_set_text(GTK_LABEL(state->label), status_buf);
         return;
     }
 
+    GError *error = nullptr;
     gsize response_len = 0;
     const char *response_data =
         static_cast<const char *>(g_bytes_get_data(response_bytes, &response_len));
@@ -1094,8 +5783,6 @@ static void on_diarize_response(GObject *source, GAsyncResult *result,
         g_warning("JSON parse error: %s", error->message);
         g_error_free(error);
         g_object_unref(parser);
-        g_bytes_unref(response_bytes);
-        refresh_notes_list(state);
         return;
     }
 
@@ -1109,8 +5796,6 @@ static void on_diarize_response(GObject *source, GAsyncResult *result,
                    "Diarization failed: %s", err_msg);
         gtk_label_set_text(GTK_LABEL(state->label), status_buf);
         g_object_unref(parser);
-        g_bytes_unref(response_bytes);
-        refresh_notes_list(state);
         return;
     }
 
@@ -1183,67 +5868,25 @@ static void on_diarize_response(GObject *source, GAsyncResult *result,
         gtk_label_set_text(GTK_LABEL(state->label),
                            "Diarization failed: no segments in response");
         g_object_unref(parser);
-        g_bytes_unref(response_bytes);
-        refresh_notes_list(state);
         return;
     }
 
     g_object_unref(parser);
-    g_bytes_unref(response_bytes);
 
-    gtk_label_set_text(GTK_LABEL(state->label), "Diarization complete");
-    refresh_notes_list(state);
+    set_job_status(state, "Diarization complete", ApiEndpoint::DIARIZE);
 }
 
-static void diarize_note(AppState *state, int note_index) {
+static void diarize_note(AppState *state, int note_index,
+                         ApiPriority priority) {
     if (note_index < 0 ||
         note_index >= static_cast<int>(state->notes.size()))
         return;
 
-    VoiceNote &note = state->notes[static_cast<size_t>(note_index)];
-
-    GError *error = nullptr;
-    GMappedFile *mapped = g_mapped_file_new(note.filepath.c_str(), FALSE, &error);
-    if (mapped == nullptr) {
-        gtk_label_set_text(GTK_LABEL(state->label),
-                           "Failed to read audio file");
-        if (error) {
-            g_warning("File read error: %s", error->message);
-            g_error_free(error);
-        }
-        note.diarizing = false;
-        refresh_notes_list(state);
-        return;
-    }
-    GBytes *file_bytes = g_mapped_file_get_bytes(mapped);
-    g_mapped_file_unref(mapped);
-
-    SoupMultipart *multipart = soup_multipart_new(SOUP_FORM_MIME_TYPE_MULTIPART);
-    soup_multipart_append_form_string(multipart, "model", "voxtral-mini-latest");
-    soup_multipart_append_form_string(multipart, "diarize", "true");
-    soup_multipart_append_form_string(multipart, "timestamp_granularities",
-                                       "segment");
-
-    std::filesystem::path fp(note.filepath);
-    std::string filename = fp.filename().string();
-    soup_multipart_append_form_file(multipart, "file", filename.c_str(),
-                                     "audio/wav", file_bytes);
-    g_bytes_unref(file_bytes);
-
-    SoupMessage *msg = soup_message_new_from_multipart(
-        "https://api.mistral.ai/v1/audio/transcriptions", multipart);
-    soup_multipart_free(multipart);
-
-    SoupMessageHeaders *headers = soup_message_get_request_headers(msg);
-    std::string auth = "Bearer " + state->api_key;
-    soup_message_headers_replace(headers, "Authorization", auth.c_str());
-
-    auto *cb_data = new DiarizeCallbackData{state, note_index};
-
-    soup_session_send_and_read_async(state->soup_session, msg,
-                                      G_PRIORITY_DEFAULT, nullptr,
-                                      on_diarize_response, cb_data);
-    g_object_unref(msg);
+    ApiJob *job = api_job_new(state, ApiEndpoint::DIARIZE, priority,
+                              state->notes[static_cast<size_t>(note_index)].id);
+    job->prepare = api_prepare_note;
+    job->done = on_diarize_done;
+    api_submit(state, job);
 }
 
 static void on_diarize_clicked(GtkWidget *button, gpointer userdata) {
@@ -1261,7 +5904,7 @@ static void on_diarize_clicked(GtkWidget *button, gpointer userdata) {
     refresh_notes_list(state);
 
     gtk_label_set_text(GTK_LABEL(state->label), "Diarizing...");
-    diarize_note(state, note_index);
+    diarize_note(state, note_index, ApiPriority::INTERACTIVE);
 }
 
 static void on_copy_clicked(GtkWidget *button, gpointer userdata) {
@@ -1312,11 +5955,15 @@ static void on_save_as_clicked(GtkWidget *button, gpointer userdata) {
     gtk_file_chooser_set_current_name(
         GTK_FILE_CHOOSER(dialog), fp.filename().c_str());
 
-    // Add WAV file filter
-    GtkFileFilter *filter = gtk_file_filter_new();
-    gtk_file_filter_set_name(filter, "WAV files");
-    gtk_file_filter_add_pattern(filter, "*.wav");
-    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter);
+    // Filter on the note's own format
+    const CodecInfo *codec = codec_for_path(fp);
+    if (codec != nullptr) {
+        GtkFileFilter *filter = gtk_file_filter_new();
+        std::string pattern = std::string("*") + codec->extension;
+        gtk_file_filter_set_name(filter, codec->label);
+        gtk_file_filter_add_pattern(filter, pattern.c_str());
+        gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter);
+    }
 
     if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
         char *dest = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
@@ -1352,7 +5999,7 @@ static void on_transcribe_clicked(GtkWidget *button, gpointer userdata) {
     refresh_notes_list(state);
 
     gtk_label_set_text(GTK_LABEL(state->label), "Transcribing...");
-    transcribe_note(state, note_index);
+    transcribe_note(state, note_index, ApiPriority::INTERACTIVE);
 }
 
 static void refresh_notes_list(AppState *state) {
@@ -1506,7 +6153,7 @@ static void on_record_toggled(GtkWidget * /*button*/, gpointer userdata) {
         }
         // Hide save/discard if visible (implicit discard)
         if (gtk_widget_get_visible(state->save_discard_box)) {
-            state->audio_buffer.clear();
+            wav_writer_discard(&state->recording_file);
             state->live_transcription.clear();
             if (state->live_transcription_scroll != nullptr) {
                 gtk_widget_hide(state->live_transcription_scroll);
@@ -1534,6 +6181,46 @@ static void on_source_info(pa_context * /*c*/, const pa_source_info *info,
     state->audio_sources.emplace_back(info->name, info->description);
 }
 
+static void update_record_button_sensitivity(AppState *state) {
+    if (state->record_button == nullptr) return;
+    gtk_widget_set_sensitive(state->record_button,
+                             state->pa_ready && state->capture_ready);
+}
+
+// Main-loop side of a capture context state change
+static gboolean on_capture_context_changed(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    if (state->capture_ctx == nullptr) return G_SOURCE_REMOVE;
+
+    pa_threaded_mainloop_lock(state->capture_ml);
+    pa_context_state_t ctx_state = pa_context_get_state(state->capture_ctx);
+    int err = pa_context_errno(state->capture_ctx);
+    pa_threaded_mainloop_unlock(state->capture_ml);
+
+    bool was_ready = state->capture_ready;
+    state->capture_ready = (ctx_state == PA_CONTEXT_READY);
+    if (was_ready && !state->capture_ready) {
+        g_warning("PulseAudio capture context failed: %s", pa_strerror(err));
+        if (state->recording) on_archive_failed(state);
+        if (state->dictating) stop_dictation(state);
+    }
+    update_record_button_sensitivity(state);
+    return G_SOURCE_REMOVE;
+}
+
+// Runs on the capture thread
+static void on_capture_context_state(pa_context *c, void *userdata) {
+    switch (pa_context_get_state(c)) {
+    case PA_CONTEXT_READY:
+    case PA_CONTEXT_FAILED:
+    case PA_CONTEXT_TERMINATED:
+        g_idle_add(on_capture_context_changed, userdata);
+        break;
+    default:
+        break;
+    }
+}
+
 static void on_pa_context_state(pa_context *c, void *userdata) {
     auto *state = static_cast<AppState *>(userdata);
 
@@ -1543,9 +6230,7 @@ static void on_pa_context_state(pa_context *c, void *userdata) {
         state->audio_sources.clear();
         pa_operation_unref(
             pa_context_get_source_info_list(c, on_source_info, state));
-        if (state->record_button != nullptr) {
-            gtk_widget_set_sensitive(state->record_button, TRUE);
-        }
+        update_record_button_sensitivity(state);
         if (state->label != nullptr) {
             if (!state->transcription_available) {
                 gtk_label_set_text(GTK_LABEL(state->label),
@@ -1558,9 +6243,7 @@ static void on_pa_context_state(pa_context *c, void *userdata) {
     case PA_CONTEXT_FAILED:
     case PA_CONTEXT_TERMINATED:
         state->pa_ready = false;
-        if (state->record_button != nullptr) {
-            gtk_widget_set_sensitive(state->record_button, FALSE);
-        }
+        update_record_button_sensitivity(state);
         if (state->label != nullptr) {
             gtk_label_set_text(GTK_LABEL(state->label), "Audio unavailable");
         }
@@ -1579,6 +6262,17 @@ static void init_pulseaudio(AppState *state) {
     state->pa_ctx = pa_context_new(api, "linscribe");
     pa_context_set_state_callback(state->pa_ctx, on_pa_context_state, state);
     pa_context_connect(state->pa_ctx, nullptr, PA_CONTEXT_NOFLAGS, nullptr);
+
+    // Capture gets its own context on a dedicated thread, so a stalled
+    // GTK main loop can never delay pa_stream_peek and lose audio
+    state->capture_ml = pa_threaded_mainloop_new();
+    state->capture_ctx = pa_context_new(
+        pa_threaded_mainloop_get_api(state->capture_ml), "linscribe-capture");
+    pa_context_set_state_callback(state->capture_ctx,
+                                  on_capture_context_state, state);
+    pa_context_connect(state->capture_ctx, nullptr, PA_CONTEXT_NOFLAGS,
+                       nullptr);
+    pa_threaded_mainloop_start(state->capture_ml);
 }
 
 static void cleanup_pulseaudio(AppState *state) {
@@ -1588,11 +6282,20 @@ static void cleanup_pulseaudio(AppState *state) {
         pa_stream_unref(state->playback_stream);
         state->playback_stream = nullptr;
     }
-    // Clean up recording stream
-    if (state->stream != nullptr) {
-        pa_stream_disconnect(state->stream);
-        pa_stream_unref(state->stream);
-        state->stream = nullptr;
+    // Clean up capture streams and the capture thread
+    stop_capture_pump(state);
+    if (state->capture_ml != nullptr) {
+        close_capture(state, &state->capture);
+        close_capture(state, &state->live_capture);
+        pa_threaded_mainloop_lock(state->capture_ml);
+        pa_context_disconnect(state->capture_ctx);
+        pa_context_unref(state->capture_ctx);
+        state->capture_ctx = nullptr;
+        pa_threaded_mainloop_unlock(state->capture_ml);
+        pa_threaded_mainloop_stop(state->capture_ml);
+        pa_threaded_mainloop_free(state->capture_ml);
+        state->capture_ml = nullptr;
+        state->capture_ready = false;
     }
     if (state->pa_ctx != nullptr) {
         pa_context_disconnect(state->pa_ctx);
@@ -1623,57 +6326,169 @@ static std::string load_saved_api_key(AppState *state) {
     return key;
 }
 
-static void save_api_key(AppState *state, const std::string &key) {
-    std::ofstream out(get_api_key_path(state));
+static void save_api_key(AppState *state, const std::string &key) {
+    std::ofstream out(get_api_key_path(state));
+    if (out) {
+        out << key;
+    }
+}
+
+static std::string get_hotkey_path(AppState *state) {
+    return state->data_dir + "/dictation_hotkey";
+}
+
+static std::string load_saved_hotkey(AppState *state) {
+    std::ifstream in(get_hotkey_path(state));
+    if (!in) return "<Ctrl><Shift>space";
+    std::string key;
+    std::getline(in, key);
+    while (!key.empty() && (key.back() == '\n' || key.back() == '\r' ||
+                            key.back() == ' '))
+        key.pop_back();
+    return key.empty() ? "<Ctrl><Shift>space" : key;
+}
+
+static void save_hotkey(AppState *state, const std::string &key) {
+    std::ofstream out(get_hotkey_path(state));
+    if (out) {
+        out << key;
+    }
+}
+
+static std::string get_audio_device_path(AppState *state) {
+    return state->data_dir + "/audio_device";
+}
+
+static std::string load_saved_audio_device(AppState *state) {
+    std::ifstream in(get_audio_device_path(state));
+    if (!in) return "";
+    std::string dev;
+    std::getline(in, dev);
+    while (!dev.empty() && (dev.back() == '\n' || dev.back() == '\r' ||
+                            dev.back() == ' '))
+        dev.pop_back();
+    return dev;
+}
+
+static void save_audio_device(AppState *state, const std::string &dev) {
+    std::ofstream out(get_audio_device_path(state));
+    if (out) {
+        out << dev;
+    }
+}
+
+static std::string get_archive_format_path(AppState *state) {
+    return state->data_dir + "/archive_format";
+}
+
+static const CodecInfo *load_saved_archive_format(AppState *state) {
+    std::ifstream in(get_archive_format_path(state));
+    std::string key;
+    if (in) std::getline(in, key);
+    while (!key.empty() && (key.back() == '\n' || key.back() == '\r' ||
+                            key.back() == ' '))
+        key.pop_back();
+    const CodecInfo *codec = codec_by_key(key);
+    return codec != nullptr ? codec : &AUDIO_CODECS[0];
+}
+
+static void save_archive_format(AppState *state, const CodecInfo *codec) {
+    std::ofstream out(get_archive_format_path(state));
+    if (out) {
+        out << codec->key;
+    }
+}
+
+static std::string get_upload_parallelism_path(AppState *state) {
+    return state->data_dir + "/upload_parallelism";
+}
+
+static int load_saved_upload_parallelism(AppState *state) {
+    std::ifstream in(get_upload_parallelism_path(state));
+    int value = 0;
+    if (!(in >> value)) return DEFAULT_UPLOAD_PARALLELISM;
+    return std::clamp(value, 1, MAX_UPLOAD_PARALLELISM);
+}
+
+static void save_upload_parallelism(AppState *state, int value) {
+    std::ofstream out(get_upload_parallelism_path(state));
+    if (out) {
+        out << value;
+    }
+}
+
+static std::string get_connection_keepalive_path(AppState *state) {
+    return state->data_dir + "/connection_keepalive";
+}
+
+static int load_saved_connection_keepalive(AppState *state) {
+    std::ifstream in(get_connection_keepalive_path(state));
+    int value = 0;
+    if (!(in >> value)) return DEFAULT_CONNECTION_KEEPALIVE;
+    return std::clamp(value, 0, MAX_CONNECTION_KEEPALIVE);
+}
+
+static void save_connection_keepalive(AppState *state, int value) {
+    std::ofstream out(get_connection_keepalive_path(state));
     if (out) {
-        out << key;
+        out << value;
     }
 }
 
-static std::string get_hotkey_path(AppState *state) {
-    return state->data_dir + "/dictation_hotkey";
+static std::string get_realtime_standby_path(AppState *state) {
+    return state->data_dir + "/realtime_standby";
 }
 
-static std::string load_saved_hotkey(AppState *state) {
-    std::ifstream in(get_hotkey_path(state));
-    if (!in) return "<Ctrl><Shift>space";
-    std::string key;
-    std::getline(in, key);
-    while (!key.empty() && (key.back() == '\n' || key.back() == '\r' ||
-                            key.back() == ' '))
-        key.pop_back();
-    return key.empty() ? "<Ctrl><Shift>space" : key;
+static bool load_saved_realtime_standby(AppState *state) {
+    std::ifstream in(get_realtime_standby_path(state));
+    int value = 0;
+    return (in >> value) && value != 0;
 }
 
-static void save_hotkey(AppState *state, const std::string &key) {
-    std::ofstream out(get_hotkey_path(state));
+static void save_realtime_standby(AppState *state, bool enabled) {
+    std::ofstream out(get_realtime_standby_path(state));
     if (out) {
-        out << key;
+        out << (enabled ? 1 : 0);
     }
 }
 
-static std::string get_audio_device_path(AppState *state) {
-    return state->data_dir + "/audio_device";
+static std::string get_uplink_frames_path(AppState *state) {
+    return state->data_dir + "/uplink_frames";
 }
 
-static std::string load_saved_audio_device(AppState *state) {
-    std::ifstream in(get_audio_device_path(state));
-    if (!in) return "";
-    std::string dev;
-    std::getline(in, dev);
-    while (!dev.empty() && (dev.back() == '\n' || dev.back() == '\r' ||
-                            dev.back() == ' '))
-        dev.pop_back();
-    return dev;
+// "<dictation ms> <live transcript ms>"
+static void load_saved_uplink_frames(AppState *state) {
+    std::ifstream in(get_uplink_frames_path(state));
+    int dictation = 0, live = 0;
+    if (!(in >> dictation >> live)) dictation = live = 0;
+    state->dictation_frame_ms =
+        snap_uplink_frame_ms(dictation, DEFAULT_DICTATION_FRAME_MS);
+    state->live_frame_ms = snap_uplink_frame_ms(live, DEFAULT_LIVE_FRAME_MS);
 }
 
-static void save_audio_device(AppState *state, const std::string &dev) {
-    std::ofstream out(get_audio_device_path(state));
+static void save_uplink_frames(AppState *state) {
+    std::ofstream out(get_uplink_frames_path(state));
     if (out) {
-        out << dev;
+        out << state->dictation_frame_ms << ' ' << state->live_frame_ms;
     }
 }
 
+static std::string get_journal_sync_path(AppState *state) {
+    return state->data_dir + "/journal_sync";
+}
+
+// "<ms> <bytes>": how long, and how much, live transcript may wait
+// before it is synced to disk
+static void load_saved_journal_sync(AppState *state) {
+    std::ifstream in(get_journal_sync_path(state));
+    int ms = 0, bytes = 0;
+    if (!(in >> ms >> bytes)) ms = bytes = 0;
+    state->journal_sync_ms =
+        ms > 0 ? std::min(ms, 60000) : DEFAULT_JOURNAL_SYNC_MS;
+    state->journal_sync_bytes =
+        bytes > 0 ? std::min(bytes, 1 << 20) : DEFAULT_JOURNAL_SYNC_BYTES;
+}
+
 static void init_transcription_service(AppState *state) {
     // Check saved key first, then fall back to environment variable
     std::string key = load_saved_api_key(state);
@@ -1686,6 +6501,7 @@ static void init_transcription_service(AppState *state) {
 
     if (key.empty()) {
         state->transcription_available = false;
+        standby_stop(state);
         return;
     }
 
@@ -1695,10 +6511,22 @@ static void init_transcription_service(AppState *state) {
         soup_session_set_timeout(state->soup_session, 120);
     }
     state->transcription_available = true;
+    configure_connection_warmup(state);
+    standby_configure(state);
 }
 
 static void cleanup_transcription_service(AppState *state) {
     ws_disconnect(state);
+    standby_stop(state);
+    api_cancel_all(state);
+    if (state->keep_warm_id != 0) {
+        g_source_remove(state->keep_warm_id);
+        state->keep_warm_id = 0;
+    }
+    if (state->api.wakeup_id != 0) {
+        g_source_remove(state->api.wakeup_id);
+        state->api.wakeup_id = 0;
+    }
     if (state->soup_session != nullptr) {
         g_object_unref(state->soup_session);
         state->soup_session = nullptr;
@@ -1712,183 +6540,512 @@ static bool is_wayland_session() {
     return type != nullptr && g_strcmp0(type, "wayland") == 0;
 }
 
-// Detect which typing tool works on this system (called once at dictation start)
-static TypingTool detect_typing_tool() {
-    if (!is_wayland_session()) return TypingTool::XDO;
+// The typing backend is probed once, on a worker thread, when the app
+// starts.  The result is reused for every dictation until the session
+// type or PATH changes or the backend stops working.  Wayland backends
+// are tried by running them with empty input, and the in-process key
+// injectors by opening them; every one is timed so Settings can show
+// what is available.  wtype goes first because it types in the user's
+// layout; after it, an injector saves a process spawn per flush.
+
+struct TypingBackendInfo {
+    TypingTool tool;
+    const char *name;
+    const char *probe_argv[4];
+};
 
-    // On Wayland, test each tool with an empty string to check if it runs
-    GError *error = nullptr;
-    gint exit_status = 0;
+static const TypingBackendInfo WAYLAND_TYPING_BACKENDS[] = {
+    // wlroots compositors only — fails on GNOME
+    {TypingTool::WTYPE, "wtype", {"wtype", "", nullptr, nullptr}},
+    // all compositors, via uinput
+    {TypingTool::YDOTOOL, "ydotool", {"ydotool", "type", "", nullptr}},
+    // X11/XWayland windows only
+    {TypingTool::XDOTOOL, "xdotool", {"xdotool", "type", "", nullptr}},
+};
 
-    // Try wtype (wlroots compositors only — fails on GNOME)
-    gchar *wtype_argv[] = {(gchar *)"wtype", (gchar *)"", nullptr};
-    if (g_spawn_sync(nullptr,
-                     wtype_argv,
-                     nullptr,
-                     static_cast<GSpawnFlags>(G_SPAWN_SEARCH_PATH |
-                         G_SPAWN_STDOUT_TO_DEV_NULL |
-                         G_SPAWN_STDERR_TO_DEV_NULL),
-                     nullptr, nullptr, nullptr, nullptr, &exit_status,
-                     &error)) {
-        if (g_spawn_check_wait_status(exit_status, nullptr)) {
-            g_message("Dictation will use wtype");
-            return TypingTool::WTYPE;
-        }
-    }
-    g_clear_error(&error);
-
-    // Try ydotool (works on all Wayland compositors via uinput)
-    gchar *ydotool_argv[] = {(gchar *)"ydotool", (gchar *)"type",
-                             (gchar *)"", nullptr};
-    if (g_spawn_sync(nullptr,
-                     ydotool_argv,
-                     nullptr,
-                     static_cast<GSpawnFlags>(G_SPAWN_SEARCH_PATH |
-                         G_SPAWN_STDOUT_TO_DEV_NULL |
-                         G_SPAWN_STDERR_TO_DEV_NULL),
-                     nullptr, nullptr, nullptr, nullptr, &exit_status,
-                     &error)) {
-        if (g_spawn_check_wait_status(exit_status, nullptr)) {
-            g_message("Dictation will use ydotool");
-            return TypingTool::YDOTOOL;
-        }
-    }
-    g_clear_error(&error);
-
-    // Try xdotool (X11/XWayland windows only)
-    gchar *xdotool_argv[] = {(gchar *)"xdotool", (gchar *)"type",
-                             (gchar *)"", nullptr};
-    if (g_spawn_sync(nullptr,
-                     xdotool_argv,
-                     nullptr,
-                     static_cast<GSpawnFlags>(G_SPAWN_SEARCH_PATH |
-                         G_SPAWN_STDOUT_TO_DEV_NULL |
-                         G_SPAWN_STDERR_TO_DEV_NULL),
-                     nullptr, nullptr, nullptr, nullptr, &exit_status,
-                     &error)) {
-        if (g_spawn_check_wait_status(exit_status, nullptr)) {
-            g_message("Dictation will use xdotool");
-            return TypingTool::XDOTOOL;
-        }
-    }
-    g_clear_error(&error);
-
-    g_warning("No working typing tool found (need wtype, ydotool, or xdotool)");
-    return TypingTool::NONE;
-}
-
-// Flush accumulated dictation text in one batch (runs as GLib idle callback)
-static gboolean flush_dictation_buffer(gpointer userdata) {
-    auto *state = static_cast<AppState *>(userdata);
-    state->dictation_flush_id = 0;
+struct TypingProbe {
+    AppState *state;
+    bool wayland;
+    std::vector<TypingProbeResult> results;
+    KeyInjector ydotoold;
+    KeyInjector uinput;
+};
 
-    if (state->dictation_buffer.empty() || !state->dictating)
-        return G_SOURCE_REMOVE;
+static void typing_probe_injector(TypingProbe *probe, TypingTool tool,
+                                  const char *name,
+                                  bool (*open_fn)(KeyInjector *),
+                                  KeyInjector *k) {
+    gint64 start = g_get_monotonic_time();
+    bool ok = open_fn(k);
+    probe->results.push_back(
+        {tool, name, ok,
+         static_cast<double>(g_get_monotonic_time() - start) / 1000.0});
+}
 
-    std::string text = std::move(state->dictation_buffer);
-    state->dictation_buffer.clear();
+// Backends can appear or break while the app runs (ydotoold started,
+// /dev/uinput permissions changed), so a cached probe is only trusted
+// for this long before dictation checks again
+static constexpr gint64 TYPING_PROBE_TTL_SECONDS = 600;
 
-    static constexpr auto SPAWN_FLAGS = static_cast<GSpawnFlags>(
-        G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL |
-        G_SPAWN_STDERR_TO_DEV_NULL);
+// Run argv to completion with output discarded; true if it exited 0
+static bool run_quiet_command(const char *const *argv) {
+    gint exit_status = 0;
+    if (!g_spawn_sync(nullptr, const_cast<gchar **>(argv), nullptr,
+                      static_cast<GSpawnFlags>(G_SPAWN_SEARCH_PATH |
+                                               G_SPAWN_STDOUT_TO_DEV_NULL |
+                                               G_SPAWN_STDERR_TO_DEV_NULL),
+                      nullptr, nullptr, nullptr, nullptr, &exit_status,
+                      nullptr)) {
+        return false;
+    }
+    return g_spawn_check_wait_status(exit_status, nullptr);
+}
 
-    switch (state->typing_tool) {
-    case TypingTool::XDO:
-        if (state->xdo != nullptr) {
-            xdo_enter_text_window(state->xdo, CURRENTWINDOW, text.c_str(),
-                                   12000);
+// Keystrokes are injected on a worker thread so pacing never stalls the
+// main loop.  Text, backend changes and shutdown travel through one
+// queue, which keeps them in order.  Text that a backend fails to type
+// is held until the probe picks a new backend, then typed with that.
+
+static constexpr gulong TYPING_KEY_DELAY_US = 12000;
+static constexpr size_t TYPING_XDO_SLICE = 16;  // characters per xdo call
+static constexpr size_t TYPING_COMMAND_SLICE = 64;  // per wtype/ydotool/xdotool
+static constexpr int TYPING_MAX_ATTEMPTS = 3;   // backends tried per text
+static constexpr gint64 TYPING_EXCLUDE_SECONDS = 300;
+
+static void probe_typing_tools(AppState *state);
+
+// A backend that failed on real text is left out of the probe's choice
+// for a while, since it would still pass the empty-input check.  The
+// failure may have been transient, and on X11 libxdo is the only
+// backend, so it gets another go once TYPING_EXCLUDE_SECONDS pass.
+static bool typing_tool_excluded(AppState *state, TypingTool tool) {
+    auto it = state->typing_excluded.find(tool);
+    return it != state->typing_excluded.end() &&
+           g_get_monotonic_time() - it->second <
+               TYPING_EXCLUDE_SECONDS * G_USEC_PER_SEC;
+}
+
+// Forget exclusions that have run out; true if there were any
+static bool typing_exclusions_expire(AppState *state) {
+    size_t before = state->typing_excluded.size();
+    for (auto it = state->typing_excluded.begin();
+         it != state->typing_excluded.end();) {
+        if (typing_tool_excluded(state, it->first)) {
+            ++it;
+        } else {
+            it = state->typing_excluded.erase(it);
         }
-        break;
-    case TypingTool::WTYPE: {
-        gchar *argv[] = {
-            (gchar *)"wtype", (gchar *)"--", (gchar *)text.c_str(), nullptr};
-        g_spawn_sync(nullptr, argv, nullptr, SPAWN_FLAGS, nullptr, nullptr,
-                     nullptr, nullptr, nullptr, nullptr);
-        break;
     }
-    case TypingTool::YDOTOOL: {
-        gchar *argv[] = {
-            (gchar *)"ydotool", (gchar *)"type", (gchar *)"--",
-            (gchar *)text.c_str(), nullptr};
-        g_spawn_sync(nullptr, argv, nullptr, SPAWN_FLAGS, nullptr, nullptr,
-                     nullptr, nullptr, nullptr, nullptr);
-        break;
+    return state->typing_excluded.size() != before;
+}
+
+// "Check Again" in Settings: the user wants every backend reconsidered
+static void on_recheck_typing(AppState *state) {
+    state->typing_excluded.clear();
+    probe_typing_tools(state);
+}
+
+// Byte length of at most `max_chars` UTF-8 characters starting at `pos`
+static size_t utf8_prefix(const std::string &text, size_t pos,
+                          size_t max_chars) {
+    const char *start = text.c_str() + pos;
+    const char *end = text.c_str() + text.size();
+    const char *p = start;
+    for (size_t i = 0; i < max_chars && p < end; i++) p = g_utf8_next_char(p);
+    return static_cast<size_t>(std::min(p, end) - start);
+}
+
+static bool typing_cancelled(TypingWorker *w, uint64_t generation) {
+    return w->generation.load(std::memory_order_acquire) != generation;
+}
+
+// Types `text` a slice at a time, stopping early if the dictation is
+// cancelled.  Returns false if the backend failed; `done` is how many
+// bytes were typed either way.
+static bool typing_worker_type(TypingWorker *w, const std::string &text,
+                               uint64_t generation, size_t *done) {
+    size_t pos = 0;
+    bool ok = true;
+    std::string slice;
+    while (ok && pos < text.size() && !typing_cancelled(w, generation)) {
+        size_t n = 0;
+        switch (w->tool) {
+        case TypingTool::XDO:
+            n = utf8_prefix(text, pos, TYPING_XDO_SLICE);
+            slice.assign(text, pos, n);
+            ok = w->xdo != nullptr &&
+                 xdo_enter_text_window(w->xdo, CURRENTWINDOW, slice.c_str(),
+                                       TYPING_KEY_DELAY_US) == 0;
+            break;
+        case TypingTool::YDOTOOLD:
+        case TypingTool::UINPUT:
+            n = utf8_prefix(text, pos, 1);
+            ok = key_injector_type(&w->keys, text.c_str() + pos, n);
+            if (ok) g_usleep(TYPING_KEY_DELAY_US);
+            break;
+        case TypingTool::WTYPE: {
+            n = utf8_prefix(text, pos, TYPING_COMMAND_SLICE);
+            slice.assign(text, pos, n);
+            const char *argv[] = {"wtype", "--", slice.c_str(), nullptr};
+            ok = run_quiet_command(argv);
+            break;
+        }
+        case TypingTool::YDOTOOL: {
+            n = utf8_prefix(text, pos, TYPING_COMMAND_SLICE);
+            slice.assign(text, pos, n);
+            const char *argv[] = {"ydotool", "type", "--", slice.c_str(),
+                                  nullptr};
+            ok = run_quiet_command(argv);
+            break;
+        }
+        case TypingTool::XDOTOOL: {
+            n = utf8_prefix(text, pos, TYPING_COMMAND_SLICE);
+            slice.assign(text, pos, n);
+            const char *argv[] = {"xdotool", "type", "--clearmodifiers", "--",
+                                  slice.c_str(), nullptr};
+            ok = run_quiet_command(argv);
+            break;
+        }
+        case TypingTool::NONE:
+            ok = false;
+            break;
+        }
+        if (ok) {
+            pos += n;
+            w->backlog.fetch_sub(n, std::memory_order_relaxed);
+        } else if (n > 0 && w->tool != TypingTool::YDOTOOLD &&
+                   w->tool != TypingTool::UINPUT) {
+            // A slice may fail after part of it was typed; typing it again
+            // could double it, so it is given up instead
+            g_warning("Typing failed partway through %zu bytes, which are "
+                      "not retried", n);
+            pos += n;
+            w->backlog.fetch_sub(n, std::memory_order_relaxed);
+        }
     }
-    case TypingTool::XDOTOOL: {
-        gchar *argv[] = {
-            (gchar *)"xdotool", (gchar *)"type", (gchar *)"--clearmodifiers",
-            (gchar *)"--", (gchar *)text.c_str(), nullptr};
-        g_spawn_sync(nullptr, argv, nullptr, SPAWN_FLAGS, nullptr, nullptr,
-                     nullptr, nullptr, nullptr, nullptr);
-        break;
+    *done = pos;
+    return ok;
+}
+
+static void typing_worker_discard_unsent(TypingWorker *w) {
+    w->backlog.fetch_sub(w->unsent.size(), std::memory_order_relaxed);
+    w->unsent.clear();
+}
+
+static void typing_worker_set_backend(TypingWorker *w, TypingItem *item) {
+    key_injector_close(&w->keys);
+    if (w->xdo != nullptr) {
+        xdo_free(w->xdo);
+        w->xdo = nullptr;
     }
-    case TypingTool::NONE:
-        break;
+    w->tool = item->tool;
+    w->keys = std::move(item->keys);
+    item->keys.fd = -1;
+    if (w->tool == TypingTool::XDO) {
+        w->xdo = xdo_new(nullptr);
+        if (w->xdo == nullptr) {
+            g_warning("Failed to create xdo handle");
+            w->tool = TypingTool::NONE;
+        }
     }
+}
 
+static gboolean on_typing_failed(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    state->typing_excluded[state->typer.failed_tool.load()] =
+        g_get_monotonic_time();
+    g_warning("Typing backend failed — checking the other backends");
+    probe_typing_tools(state);
     return G_SOURCE_REMOVE;
 }
 
-// Queue text for typing — batches rapid deltas, flushes on next idle
-static void type_text(AppState *state, const char *text) {
-    if (text == nullptr || text[0] == '\0') return;
+static gpointer typing_worker_thread(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    TypingWorker *w = &state->typer;
+    TypingItem item;
 
-    state->dictation_buffer += text;
+    for (;;) {
+        typing_queue_wait(&w->queue, &item);
+        if (item.kind == TypingItem::QUIT) break;
 
-    if (state->dictation_flush_id == 0) {
-        state->dictation_flush_id =
-            g_idle_add(flush_dictation_buffer, state);
+        if (!w->unsent.empty() && typing_cancelled(w, w->unsent_generation)) {
+            typing_worker_discard_unsent(w);
+        }
+        bool retry = false;
+        if (item.kind == TypingItem::BACKEND) {
+            typing_worker_set_backend(w, &item);
+            if (w->unsent.empty() || w->tool == TypingTool::NONE) continue;
+            item.text = std::move(w->unsent);
+            item.generation = w->unsent_generation;
+            w->unsent.clear();
+            retry = true;
+        } else if (!w->unsent.empty()) {
+            // Keep the order: wait behind the text already held
+            w->unsent += item.text;
+            continue;
+        }
+
+        size_t done = 0;
+        bool ok = typing_worker_type(w, item.text, item.generation, &done);
+        if (w->keys.skipped > 0) {
+            g_message("Skipped %zu characters the keyboard can't type",
+                      w->keys.skipped);
+            w->keys.skipped = 0;
+        }
+        if (ok || typing_cancelled(w, item.generation)) {
+            w->backlog.fetch_sub(item.text.size() - done,
+                                 std::memory_order_relaxed);
+            continue;
+        }
+
+        w->unsent.assign(item.text, done, std::string::npos);
+        w->unsent_generation = item.generation;
+        w->unsent_attempts = retry ? w->unsent_attempts + 1 : 1;
+        if (w->unsent_attempts >= TYPING_MAX_ATTEMPTS) {
+            g_warning("Dropping %zu bytes of dictated text after %d typing "
+                      "backends failed on it", w->unsent.size(),
+                      w->unsent_attempts);
+            typing_worker_discard_unsent(w);
+        }
+        // With no backend yet the probe is already running
+        if (w->tool != TypingTool::NONE) {
+            w->failed_tool.store(w->tool);
+            g_idle_add(on_typing_failed, state);
+        }
+    }
+
+    key_injector_close(&w->keys);
+    if (w->xdo != nullptr) {
+        xdo_free(w->xdo);
+        w->xdo = nullptr;
     }
+    return nullptr;
 }
 
-static void on_dictation_stream_read(pa_stream *s, size_t /*nbytes*/,
-                                      void *userdata) {
-    auto *state = static_cast<AppState *>(userdata);
+static void typing_worker_start(AppState *state) {
+    if (state->typer.thread != nullptr) return;
+    typing_queue_init(&state->typer.queue);
+    state->typer.thread =
+        g_thread_new("linscribe-typing", typing_worker_thread, state);
+}
 
-    const void *data;
-    size_t length;
+static void typing_worker_stop(AppState *state) {
+    TypingWorker *w = &state->typer;
+    if (w->thread == nullptr) return;
+    w->generation.fetch_add(1, std::memory_order_release);
+    auto *item = new TypingItem;
+    item->kind = TypingItem::QUIT;
+    typing_queue_push(&w->queue, item);
+    g_thread_join(w->thread);
+    w->thread = nullptr;
+    typing_queue_clear(&w->queue);
+}
 
-    while (pa_stream_peek(s, &data, &length) >= 0 && length > 0) {
-        if (data != nullptr) {
-            auto num_samples = length / sizeof(int16_t);
-            auto *samples = static_cast<const int16_t *>(data);
-            ws_send_audio(state, samples, num_samples);
+static void typing_worker_send_text(AppState *state, std::string text) {
+    TypingWorker *w = &state->typer;
+    auto *item = new TypingItem;
+    item->generation = w->generation.load(std::memory_order_relaxed);
+    size_t backlog = w->backlog.fetch_add(text.size(),
+                                          std::memory_order_relaxed) +
+                     text.size();
+    w->peak_backlog = std::max(w->peak_backlog, backlog);
+    item->text = std::move(text);
+    typing_queue_push(&w->queue, item);
+}
+
+// Hand the probe's choice to the worker, with the injector if it has one
+static void typing_worker_set_tool(AppState *state, TypingTool tool,
+                                   KeyInjector *keys) {
+    auto *item = new TypingItem;
+    item->kind = TypingItem::BACKEND;
+    item->tool = tool;
+    if (keys != nullptr) {
+        item->keys = std::move(*keys);
+        keys->fd = -1;
+    }
+    typing_queue_push(&state->typer.queue, item);
+}
+
+// Drop queued text; called when dictation stops
+static void typing_worker_cancel(AppState *state) {
+    TypingWorker *w = &state->typer;
+    w->generation.fetch_add(1, std::memory_order_release);
+    if (w->peak_backlog > 0) {
+        g_message("Typing backlog peaked at %zu bytes (about %.1f s behind)",
+                  w->peak_backlog,
+                  static_cast<double>(w->peak_backlog) *
+                      TYPING_KEY_DELAY_US / 1e6);
+    }
+    w->peak_backlog = 0;
+}
+
+static void typing_probe_thread(GTask *task, gpointer /*source*/,
+                                gpointer task_data,
+                                GCancellable * /*cancellable*/) {
+    auto *probe = static_cast<TypingProbe *>(task_data);
+    if (!probe->wayland) {
+        gint64 start = g_get_monotonic_time();
+        xdo_t *xdo = xdo_new(nullptr);
+        bool ok = xdo != nullptr;
+        if (xdo != nullptr) xdo_free(xdo);
+        probe->results.push_back(
+            {TypingTool::XDO, "libxdo", ok,
+             static_cast<double>(g_get_monotonic_time() - start) / 1000.0});
+    } else {
+        for (const TypingBackendInfo &backend : WAYLAND_TYPING_BACKENDS) {
+            if (backend.tool == TypingTool::YDOTOOL) {
+                typing_probe_injector(probe, TypingTool::YDOTOOLD,
+                                      "ydotoold socket",
+                                      key_injector_open_ydotoold,
+                                      &probe->ydotoold);
+                typing_probe_injector(probe, TypingTool::UINPUT,
+                                      "/dev/uinput",
+                                      key_injector_open_uinput,
+                                      &probe->uinput);
+            }
+            gint64 start = g_get_monotonic_time();
+            bool ok = run_quiet_command(backend.probe_argv);
+            probe->results.push_back(
+                {backend.tool, backend.name, ok,
+                 static_cast<double>(g_get_monotonic_time() - start) / 1000.0});
         }
-        pa_stream_drop(s);
     }
+    g_task_return_boolean(task, TRUE);
 }
 
-static void on_dictation_stream_state(pa_stream *s, void *userdata) {
-    auto *state = static_cast<AppState *>(userdata);
+static std::string typing_status_text(AppState *state) {
+    if (state->typing_probing) return "Checking typing backends...";
+    std::string text;
+    for (const TypingProbeResult &r : state->typing_probe_results) {
+        bool excluded = typing_tool_excluded(state, r.tool);
+        const char *note = "";
+        if (r.ok && excluded) note = " · failed while typing";
+        if (r.ok && r.tool == state->typing_tool) note = " · in use";
+        char line[128];
+        g_snprintf(line, sizeof(line), "%s%s — %s (%.0f ms)%s",
+                   text.empty() ? "" : "\n", r.name,
+                   r.ok ? "OK" : "not working", r.elapsed_ms, note);
+        text += line;
+    }
+    if (text.empty()) text = "Typing backends not checked yet";
+    return text;
+}
 
-    if (pa_stream_get_state(s) == PA_STREAM_FAILED) {
-        g_warning("Dictation PulseAudio stream failed: %s",
-                  pa_strerror(pa_context_errno(state->pa_ctx)));
+static void update_typing_status(AppState *state) {
+    if (state->typing_status_label == nullptr) return;
+    gtk_label_set_text(GTK_LABEL(state->typing_status_label),
+                       typing_status_text(state).c_str());
+}
+
+static void on_typing_probe_done(GObject * /*source*/, GAsyncResult *result,
+                                 gpointer /*userdata*/) {
+    auto *probe = static_cast<TypingProbe *>(
+        g_task_get_task_data(G_TASK(result)));
+    AppState *state = probe->state;
+
+    state->typing_probing = false;
+    state->typing_probe_valid = true;
+    state->typing_probe_results = std::move(probe->results);
+    state->typing_tool = TypingTool::NONE;
+    for (const TypingProbeResult &r : state->typing_probe_results) {
+        if (r.ok && !typing_tool_excluded(state, r.tool)) {
+            state->typing_tool = r.tool;
+            g_message("Dictation will use %s (probed in %.0f ms)", r.name,
+                      r.elapsed_ms);
+            break;
+        }
+    }
+
+    // The chosen injector stays open in the worker for the session
+    KeyInjector *chosen = nullptr;
+    if (state->typing_tool == TypingTool::YDOTOOLD) chosen = &probe->ydotoold;
+    if (state->typing_tool == TypingTool::UINPUT) chosen = &probe->uinput;
+    typing_worker_set_tool(state, state->typing_tool, chosen);
+    key_injector_close(&probe->ydotoold);
+    key_injector_close(&probe->uinput);
+    if (state->typing_tool == TypingTool::NONE) {
+        g_warning("No working typing tool found (need wtype, ydotool, "
+                  "access to /dev/uinput, or xdotool)");
+    }
+    update_typing_status(state);
+
+    // Text from a dictation started while probing is held by the worker
+    // and typed once it has the backend
+    if (state->dictating && state->typing_tool == TypingTool::NONE) {
         stop_dictation(state);
     }
 }
 
+// Re-run the probe in the background; the cached result stays in use
+// for display but not for typing until it finishes
+static void probe_typing_tools(AppState *state) {
+    if (state->typing_probing) return;
+    state->typing_probing = true;
+    state->typing_probe_valid = false;
+    state->typing_probe_time = g_get_monotonic_time();
+    update_typing_status(state);
+
+    auto *probe = new TypingProbe{state, is_wayland_session(), {}, {}, {}};
+    GTask *task = g_task_new(nullptr, nullptr, on_typing_probe_done, nullptr);
+    g_task_set_task_data(task, probe, [](gpointer data) {
+        delete static_cast<TypingProbe *>(data);
+    });
+    g_task_run_in_thread(task, typing_probe_thread);
+    g_object_unref(task);
+}
+
+// True if there is no cached result or it is too old to trust
+static bool typing_probe_stale(AppState *state) {
+    if (state->typing_probing) return false;
+    return !state->typing_probe_valid ||
+           g_get_monotonic_time() - state->typing_probe_time >
+               TYPING_PROBE_TTL_SECONDS * G_USEC_PER_SEC;
+}
+
+// Hand accumulated dictation text to the typing worker in one batch
+// (runs as GLib idle callback)
+static gboolean flush_dictation_buffer(gpointer userdata) {
+    auto *state = static_cast<AppState *>(userdata);
+    state->dictation_flush_id = 0;
+
+    if (state->dictation_buffer.empty() || !state->dictating)
+        return G_SOURCE_REMOVE;
+
+    typing_worker_send_text(state, std::move(state->dictation_buffer));
+    state->dictation_buffer.clear();
+    return G_SOURCE_REMOVE;
+}
+
+// Queue text for typing — batches rapid deltas, flushes on next idle
+static void type_text(AppState *state, const char *text) {
+    if (text == nullptr || text[0] == '\0') return;
+
+    state->dictation_buffer += text;
+
+    if (state->dictation_flush_id == 0) {
+        state->dictation_flush_id =
+            g_idle_add(flush_dictation_buffer, state);
+    }
+}
+
 static void start_dictation(AppState *state) {
     if (!state->transcription_available || state->dictating) return;
-    if (!state->pa_ready) return;
+    if (!state->pa_ready || !state->capture_ready) return;
     if (state->recording) return;  // voice note recording in progress
 
-    // Detect which typing tool to use (once per dictation session)
-    state->typing_tool = detect_typing_tool();
-    if (state->typing_tool == TypingTool::NONE) {
+    // The typing backend is normally known already.  If it has to be
+    // probed again, dictation starts anyway and text waits for the probe.
+    // A backend that failed before gets another go once its exclusion
+    // runs out
+    if (typing_exclusions_expire(state) || typing_probe_stale(state)) {
+        probe_typing_tools(state);
+    }
+    if (state->typing_probe_valid &&
+        state->typing_tool == TypingTool::NONE) {
         g_warning("No working typing tool found — cannot start dictation");
         return;
     }
 
-    if (state->typing_tool == TypingTool::XDO) {
-        state->xdo = xdo_new(nullptr);
-        if (state->xdo == nullptr) {
-            g_warning("Failed to create xdo handle");
-            state->typing_tool = TypingTool::NONE;
-            return;
-        }
-    }
-
     state->dictating = true;
 
     // Change tray icon to indicate dictation
@@ -1897,47 +7054,19 @@ static void start_dictation(AppState *state) {
                                      "Dictating");
     }
 
-    // Create PA stream for dictation
-    static const pa_sample_spec spec = {
-        .format = PA_SAMPLE_S16LE,
-        .rate = SAMPLE_RATE,
-        .channels = NUM_CHANNELS,
-    };
-
-    state->stream = pa_stream_new(state->pa_ctx, "linscribe-dictation",
-                                   &spec, nullptr);
-    if (state->stream == nullptr) {
-        g_warning("Failed to create dictation stream");
-        stop_dictation(state);
-        return;
-    }
-
-    pa_stream_set_read_callback(state->stream, on_dictation_stream_read, state);
-    pa_stream_set_state_callback(state->stream, on_dictation_stream_state,
-                                  state);
-
-    pa_buffer_attr attr = {};
-    attr.maxlength = static_cast<uint32_t>(-1);
-    attr.tlength = static_cast<uint32_t>(-1);
-    attr.prebuf = static_cast<uint32_t>(-1);
-    attr.minreq = static_cast<uint32_t>(-1);
-    attr.fragsize = 4410 * sizeof(int16_t);
-
-    const char *dev = state->audio_device.empty()
-                          ? nullptr
-                          : state->audio_device.c_str();
-    if (pa_stream_connect_record(state->stream, dev, &attr,
-                                  PA_STREAM_ADJUST_LATENCY) < 0) {
+    // Dictation is never archived, so capture straight at the WebSocket
+    // rate and skip the high-rate tap entirely
+    if (!open_capture(state, &state->capture, "linscribe-dictation",
+                      WS_SAMPLE_RATE, selected_device(state))) {
         g_warning("Failed to connect dictation stream");
-        pa_stream_unref(state->stream);
-        state->stream = nullptr;
         stop_dictation(state);
         return;
     }
+    start_capture_pump(state);
+    start_level_tick(state);
 
     // Start WebSocket transcription
     state->live_transcription.clear();
-    state->resample_phase = 0.0;
     ws_connect(state);
 
     update_dictation_menu_label(state);
@@ -1954,13 +7083,13 @@ static void stop_dictation(AppState *state) {
         state->dictation_flush_id = 0;
     }
     state->dictation_buffer.clear();
+    typing_worker_cancel(state);
 
     // Stop PA stream
-    if (state->stream != nullptr) {
-        pa_stream_disconnect(state->stream);
-        pa_stream_unref(state->stream);
-        state->stream = nullptr;
-    }
+    close_capture(state, &state->capture);
+    stop_capture_pump(state);
+    log_meter_summary("Dictation", &state->capture.meter);
+    gtk_level_bar_set_value(GTK_LEVEL_BAR(state->level_bar), 0.0);
 
     // Disconnect WebSocket
     ws_disconnect(state);
@@ -1971,12 +7100,6 @@ static void stop_dictation(AppState *state) {
                                      "linscribe", "Linscribe");
     }
 
-    // Free xdo
-    if (state->xdo != nullptr) {
-        xdo_free(state->xdo);
-        state->xdo = nullptr;
-    }
-
     update_dictation_menu_label(state);
 }
 
@@ -2028,6 +7151,12 @@ static void on_menu_transcribe(GtkMenuItem * /*item*/, gpointer user_data) {
     gtk_window_present(GTK_WINDOW(state->window));
 }
 
+static void on_menu_transcribe_all(GtkMenuItem * /*item*/,
+                                   gpointer user_data) {
+    auto *state = static_cast<AppState *>(user_data);
+    transcribe_all_pending(state);
+}
+
 static void on_menu_dictation(GtkMenuItem * /*item*/, gpointer user_data) {
     auto *state = static_cast<AppState *>(user_data);
     if (state->dictating) {
@@ -2041,45 +7170,44 @@ static void on_menu_dictation(GtkMenuItem * /*item*/, gpointer user_data) {
 
 struct AudioPreview {
     AppState *state;
-    pa_stream *stream = nullptr;
+    CaptureTap tap;  // meter-only, nothing is buffered
     GtkWidget *level_bar = nullptr;
-    double current_level = 0.0;
+    GtkWidget *level_label = nullptr;
+    uint64_t shown_clipped = UINT64_MAX;
+    int shown_lufs = INT_MIN;
 };
 
-static void on_preview_stream_read(pa_stream *s, size_t /*nbytes*/,
-                                    void *userdata) {
+static gboolean on_preview_tick(GtkWidget * /*widget*/,
+                                GdkFrameClock * /*clock*/,
+                                gpointer userdata) {
     auto *preview = static_cast<AudioPreview *>(userdata);
-
-    const void *data;
-    size_t length;
-
-    while (pa_stream_peek(s, &data, &length) >= 0 && length > 0) {
-        if (data != nullptr) {
-            auto num_samples = length / sizeof(int16_t);
-            auto *samples = static_cast<const int16_t *>(data);
-
-            double peak = calculate_peak_level(samples, num_samples);
-            if (peak >= preview->current_level) {
-                preview->current_level = peak;
-            } else {
-                preview->current_level =
-                    preview->current_level * DECAY_FACTOR +
-                    peak * (1.0 - DECAY_FACTOR);
-            }
-            gtk_level_bar_set_value(GTK_LEVEL_BAR(preview->level_bar),
-                                    preview->current_level);
-        }
-        pa_stream_drop(s);
+    if (preview->tap.stream == nullptr) return G_SOURCE_CONTINUE;
+
+    const MeterLevels &levels = preview->tap.levels;
+    gtk_level_bar_set_value(GTK_LEVEL_BAR(preview->level_bar),
+                            levels.display.load(std::memory_order_relaxed));
+
+    // Only touch the label when the rounded reading changes
+    int lufs = static_cast<int>(
+        std::lround(levels.lufs.load(std::memory_order_relaxed)));
+    uint64_t clipped = levels.clipped.load(std::memory_order_relaxed);
+    if (lufs != preview->shown_lufs || clipped != preview->shown_clipped) {
+        preview->shown_lufs = lufs;
+        preview->shown_clipped = clipped;
+        double peak = levels.peak.load(std::memory_order_relaxed);
+        char buf[96];
+        g_snprintf(buf, sizeof(buf), "Peak %.0f dBFS · %d LUFS · %"
+                   G_GUINT64_FORMAT " clipped",
+                   std::max(to_dbfs(peak), -99.0), lufs, clipped);
+        gtk_label_set_text(GTK_LABEL(preview->level_label), buf);
     }
+    return G_SOURCE_CONTINUE;
 }
 
 static void stop_audio_preview(AudioPreview *preview) {
-    if (preview->stream != nullptr) {
-        pa_stream_disconnect(preview->stream);
-        pa_stream_unref(preview->stream);
-        preview->stream = nullptr;
-    }
-    preview->current_level = 0.0;
+    close_capture(preview->state, &preview->tap);
+    preview->shown_lufs = INT_MIN;
+    preview->shown_clipped = UINT64_MAX;
     if (preview->level_bar != nullptr) {
         gtk_level_bar_set_value(GTK_LEVEL_BAR(preview->level_bar), 0.0);
     }
@@ -2087,34 +7215,8 @@ static void stop_audio_preview(AudioPreview *preview) {
 
 static void start_audio_preview(AudioPreview *preview, const char *device) {
     stop_audio_preview(preview);
-
-    if (!preview->state->pa_ready) return;
-
-    static const pa_sample_spec spec = {
-        .format = PA_SAMPLE_S16LE,
-        .rate = SAMPLE_RATE,
-        .channels = NUM_CHANNELS,
-    };
-
-    preview->stream = pa_stream_new(preview->state->pa_ctx,
-                                     "linscribe-preview", &spec, nullptr);
-    if (preview->stream == nullptr) return;
-
-    pa_stream_set_read_callback(preview->stream, on_preview_stream_read,
-                                 preview);
-
-    pa_buffer_attr attr = {};
-    attr.maxlength = static_cast<uint32_t>(-1);
-    attr.tlength = static_cast<uint32_t>(-1);
-    attr.prebuf = static_cast<uint32_t>(-1);
-    attr.minreq = static_cast<uint32_t>(-1);
-    attr.fragsize = 4410 * sizeof(int16_t);
-
-    if (pa_stream_connect_record(preview->stream, device, &attr,
-                                  PA_STREAM_ADJUST_LATENCY) < 0) {
-        pa_stream_unref(preview->stream);
-        preview->stream = nullptr;
-    }
+    open_capture(preview->state, &preview->tap, "linscribe-preview",
+                 SAMPLE_RATE, device);
 }
 
 static void on_device_combo_changed(GtkComboBox *combo, gpointer userdata) {
@@ -2173,6 +7275,13 @@ static void on_menu_settings(GtkMenuItem * /*item*/, gpointer user_data) {
     gtk_level_bar_remove_offset_value(GTK_LEVEL_BAR(preview.level_bar),
                                       GTK_LEVEL_BAR_OFFSET_FULL);
     gtk_box_pack_start(GTK_BOX(content), preview.level_bar, FALSE, FALSE, 0);
+    preview.level_label = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(preview.level_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(content), preview.level_label, FALSE, FALSE, 0);
+    preview.tap.buffered = false;
+    preview.tap.metered = true;
+    gtk_widget_add_tick_callback(preview.level_bar, on_preview_tick, &preview,
+                                 nullptr);
 
     // Start preview with currently selected device
     {
@@ -2187,6 +7296,20 @@ static void on_menu_settings(GtkMenuItem * /*item*/, gpointer user_data) {
     g_signal_connect(device_combo, "changed",
                      G_CALLBACK(on_device_combo_changed), &preview);
 
+    // Archive format for new notes
+    GtkWidget *format_label = gtk_label_new("Save Notes As:");
+    gtk_label_set_xalign(GTK_LABEL(format_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(content), format_label, FALSE, FALSE, 0);
+
+    GtkWidget *format_combo = gtk_combo_box_text_new();
+    for (const auto &c : AUDIO_CODECS) {
+        gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(format_combo), c.key,
+                                  c.label);
+    }
+    gtk_combo_box_set_active_id(GTK_COMBO_BOX(format_combo),
+                                state->archive_codec->key);
+    gtk_box_pack_start(GTK_BOX(content), format_combo, FALSE, FALSE, 0);
+
     GtkWidget *label = gtk_label_new("Mistral API Key:");
     gtk_label_set_xalign(GTK_LABEL(label), 0.0);
     gtk_box_pack_start(GTK_BOX(content), label, FALSE, FALSE, 0);
@@ -2205,6 +7328,57 @@ static void on_menu_settings(GtkMenuItem * /*item*/, gpointer user_data) {
 
     gtk_box_pack_start(GTK_BOX(content), entry, FALSE, FALSE, 0);
 
+    // Batch API requests in flight at once
+    GtkWidget *parallel_label = gtk_label_new("Parallel Uploads:");
+    gtk_label_set_xalign(GTK_LABEL(parallel_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(content), parallel_label, FALSE, FALSE, 0);
+
+    GtkWidget *parallel_spin =
+        gtk_spin_button_new_with_range(1, MAX_UPLOAD_PARALLELISM, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(parallel_spin),
+                              state->upload_parallelism);
+    gtk_box_pack_start(GTK_BOX(content), parallel_spin, FALSE, FALSE, 0);
+
+    // How often the idle API connection is refreshed
+    GtkWidget *keepalive_label =
+        gtk_label_new("Keep Connection Warm (seconds, 0 = off):");
+    gtk_label_set_xalign(GTK_LABEL(keepalive_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(content), keepalive_label, FALSE, FALSE, 0);
+
+    GtkWidget *keepalive_spin =
+        gtk_spin_button_new_with_range(0, MAX_CONNECTION_KEEPALIVE, 10);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(keepalive_spin),
+                              state->connection_keepalive);
+    gtk_box_pack_start(GTK_BOX(content), keepalive_spin, FALSE, FALSE, 0);
+
+    // Realtime uplink frame size, per mode: latency vs per-message overhead
+    GtkWidget *frames_label = gtk_label_new("Realtime Audio Frames:");
+    gtk_label_set_xalign(GTK_LABEL(frames_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(content), frames_label, FALSE, FALSE, 0);
+
+    GtkWidget *frames_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+    GtkWidget *frame_combos[2];
+    const char *frame_modes[2] = {"Dictation", "Live transcript"};
+    int frame_values[2] = {state->dictation_frame_ms, state->live_frame_ms};
+    for (int m = 0; m < 2; m++) {
+        gtk_box_pack_start(GTK_BOX(frames_box), gtk_label_new(frame_modes[m]),
+                           FALSE, FALSE, 0);
+        frame_combos[m] = gtk_combo_box_text_new();
+        for (int ms : UPLINK_FRAME_CHOICES_MS) {
+            std::string id = std::to_string(ms);
+            std::string text = id + " ms";
+            if (ms == DEFAULT_DICTATION_FRAME_MS) text += " (dictation default)";
+            if (ms == DEFAULT_LIVE_FRAME_MS) text += " (notes default)";
+            gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(frame_combos[m]),
+                                      id.c_str(), text.c_str());
+        }
+        gtk_combo_box_set_active_id(GTK_COMBO_BOX(frame_combos[m]),
+                                    std::to_string(frame_values[m]).c_str());
+        gtk_box_pack_start(GTK_BOX(frames_box), frame_combos[m], FALSE, FALSE,
+                           0);
+    }
+    gtk_box_pack_start(GTK_BOX(content), frames_box, FALSE, FALSE, 0);
+
     // Hotkey field
     GtkWidget *hotkey_label = gtk_label_new("Dictation Hotkey:");
     gtk_label_set_xalign(GTK_LABEL(hotkey_label), 0.0);
@@ -2216,6 +7390,31 @@ static void on_menu_settings(GtkMenuItem * /*item*/, gpointer user_data) {
     gtk_entry_set_text(GTK_ENTRY(hotkey_entry), state->hotkey.c_str());
     gtk_box_pack_start(GTK_BOX(content), hotkey_entry, FALSE, FALSE, 0);
 
+    // Parked realtime session for instant dictation start
+    GtkWidget *standby_check = gtk_check_button_new_with_label(
+        "Keep a realtime session ready (faster dictation start)");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(standby_check),
+                                 state->realtime_standby);
+    gtk_box_pack_start(GTK_BOX(content), standby_check, FALSE, FALSE, 0);
+
+    // Typing backend health, refreshed when a probe finishes
+    GtkWidget *typing_label = gtk_label_new("Typing Backends:");
+    gtk_label_set_xalign(GTK_LABEL(typing_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(content), typing_label, FALSE, FALSE, 0);
+
+    GtkWidget *typing_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+    state->typing_status_label = gtk_label_new(nullptr);
+    gtk_label_set_xalign(GTK_LABEL(state->typing_status_label), 0.0);
+    gtk_widget_set_hexpand(state->typing_status_label, TRUE);
+    gtk_box_pack_start(GTK_BOX(typing_box), state->typing_status_label,
+                       TRUE, TRUE, 0);
+    GtkWidget *recheck_btn = gtk_button_new_with_label("Check Again");
+    g_signal_connect_swapped(recheck_btn, "clicked",
+                             G_CALLBACK(on_recheck_typing), state);
+    gtk_box_pack_start(GTK_BOX(typing_box), recheck_btn, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(content), typing_box, FALSE, FALSE, 0);
+    update_typing_status(state);
+
     gtk_widget_show_all(content);
 
     if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
@@ -2226,11 +7425,45 @@ static void on_menu_settings(GtkMenuItem * /*item*/, gpointer user_data) {
         state->audio_device = new_device;
         save_audio_device(state, new_device);
 
+        const gchar *format_id =
+            gtk_combo_box_get_active_id(GTK_COMBO_BOX(format_combo));
+        const CodecInfo *codec = codec_by_key(format_id ? format_id : "");
+        if (codec != nullptr) {
+            state->archive_codec = codec;
+            save_archive_format(state, codec);
+        }
+
         const char *new_key = gtk_entry_get_text(GTK_ENTRY(entry));
         std::string key_str(new_key ? new_key : "");
 
         save_api_key(state, key_str);
 
+        state->upload_parallelism = gtk_spin_button_get_value_as_int(
+            GTK_SPIN_BUTTON(parallel_spin));
+        save_upload_parallelism(state, state->upload_parallelism);
+        api_schedule(state);  // use any new slots straight away
+
+        state->connection_keepalive = gtk_spin_button_get_value_as_int(
+            GTK_SPIN_BUTTON(keepalive_spin));
+        save_connection_keepalive(state, state->connection_keepalive);
+
+        state->realtime_standby = gtk_toggle_button_get_active(
+            GTK_TOGGLE_BUTTON(standby_check));
+        save_realtime_standby(state, state->realtime_standby);
+
+        // Applies from the next realtime session
+        int *frame_settings[2] = {&state->dictation_frame_ms,
+                                  &state->live_frame_ms};
+        for (int m = 0; m < 2; m++) {
+            const gchar *id =
+                gtk_combo_box_get_active_id(GTK_COMBO_BOX(frame_combos[m]));
+            if (id != nullptr) {
+                int ms = static_cast<int>(g_ascii_strtoll(id, nullptr, 10));
+                *frame_settings[m] = snap_uplink_frame_ms(ms, *frame_settings[m]);
+            }
+        }
+        save_uplink_frames(state);
+
         // Reinitialize transcription service with new key
         init_transcription_service(state);
 
@@ -2260,18 +7493,21 @@ static void on_menu_settings(GtkMenuItem * /*item*/, gpointer user_data) {
         }
 
         // Update dictation menu visibility based on transcription availability
-        if (state->dictation_menu_item != nullptr) {
+        for (GtkWidget *item : {state->dictation_menu_item,
+                                state->transcribe_all_menu_item}) {
+            if (item == nullptr) continue;
             if (state->transcription_available) {
-                gtk_widget_set_no_show_all(state->dictation_menu_item, FALSE);
-                gtk_widget_show(state->dictation_menu_item);
+                gtk_widget_set_no_show_all(item, FALSE);
+                gtk_widget_show(item);
             } else {
-                gtk_widget_hide(state->dictation_menu_item);
-                gtk_widget_set_no_show_all(state->dictation_menu_item, TRUE);
+                gtk_widget_hide(item);
+                gtk_widget_set_no_show_all(item, TRUE);
             }
         }
     }
 
     stop_audio_preview(&preview);
+    state->typing_status_label = nullptr;
     gtk_widget_destroy(dialog);
 }
 
@@ -2294,23 +7530,92 @@ static void activate(GApplication *app, gpointer user_data) {
     // Initialize data directory and load existing notes
     ensure_data_dir(state);
     state->audio_device = load_saved_audio_device(state);
+    state->archive_codec = load_saved_archive_format(state);
+    state->upload_parallelism = load_saved_upload_parallelism(state);
+    state->connection_keepalive = load_saved_connection_keepalive(state);
+    state->realtime_standby = load_saved_realtime_standby(state);
+    load_saved_uplink_frames(state);
+    load_saved_journal_sync(state);
+
+    // Drop half-written encodes, and WAVs whose encode finished but which
+    // weren't removed before we exited
+    for (const auto &entry :
+         std::filesystem::directory_iterator(state->data_dir)) {
+        const std::filesystem::path &fp = entry.path();
+        std::error_code ec;
+        if (fp.extension() == ".encoding") {
+            std::filesystem::remove(fp, ec);
+        } else if (fp.extension() == ".wav") {
+            for (const auto &c : AUDIO_CODECS) {
+                if (c.codec == AudioCodec::WAV) continue;
+                std::filesystem::path sibling(fp);
+                sibling.replace_extension(c.extension);
+                if (std::filesystem::exists(sibling)) {
+                    std::filesystem::remove(fp, ec);
+                    break;
+                }
+            }
+        }
+    }
     load_notes(state);
 
-    // Clean up any leftover partial transcription file from a previous crash
+    // The live transcript journal of a recording interrupted by a crash
+    std::string recovered_text;
+    {
+        std::string journal_path = get_transcript_journal_path(state);
+        gint64 last_us = 0;
+        if (std::filesystem::exists(journal_path) &&
+            journal_recover(journal_path, &recovered_text, &last_us) &&
+            !recovered_text.empty()) {
+            GDateTime *dt = g_date_time_new_from_unix_local(
+                last_us / G_USEC_PER_SEC);
+            gchar *when = dt != nullptr
+                              ? g_date_time_format(dt, "%Y-%m-%d %H:%M:%S")
+                              : nullptr;
+            g_message("Recovered %zu bytes of live transcript journaled "
+                      "up to %s", recovered_text.size(),
+                      when != nullptr ? when : "an unknown time");
+            g_free(when);
+            if (dt != nullptr) g_date_time_unref(dt);
+        }
+        std::error_code ec;
+        std::filesystem::remove(journal_path, ec);
+    }
+
+    // A recording still in its temp file means we crashed mid-capture:
+    // patch the header from the file size and keep it as a note
     {
-        std::string partial_path =
-            state->data_dir + "/.transcription_in_progress.txt.partial";
+        std::string partial_path = get_recording_tmp_path(state);
         if (std::filesystem::exists(partial_path)) {
-            auto fsize = std::filesystem::file_size(partial_path);
-            if (fsize > 0) {
-                g_message("Found leftover partial transcription file "
-                          "(%ju bytes) from a previous session — removing",
-                          static_cast<uintmax_t>(fsize));
+            if (wav_repair_header(partial_path, SAMPLE_RATE)) {
+                std::string path = generate_note_filename(state->data_dir);
+                std::error_code ec;
+                std::filesystem::rename(partial_path, path, ec);
+                if (!ec) {
+                    g_message("Recovered interrupted recording as %s",
+                              path.c_str());
+                    if (!recovered_text.empty()) {
+                        std::filesystem::path txt_path(path);
+                        txt_path.replace_extension(".txt");
+                        std::ofstream txt_file(txt_path);
+                        if (txt_file) txt_file << recovered_text;
+                    }
+                    load_notes(state);
+                    encode_note_async(state, path);
+                }
+            } else {
+                std::filesystem::remove(partial_path);
             }
-            std::filesystem::remove(partial_path);
         }
     }
 
+    // Re-warm API connections whenever the network comes back
+    GNetworkMonitor *monitor = g_network_monitor_get_default();
+    state->network_available =
+        g_network_monitor_get_network_available(monitor);
+    g_signal_connect(monitor, "network-changed",
+                     G_CALLBACK(on_network_changed), state);
+
     // Initialize transcription service
     init_transcription_service(state);
 
@@ -2346,6 +7651,7 @@ static void activate(GApplication *app, gpointer user_data) {
     gtk_level_bar_remove_offset_value(GTK_LEVEL_BAR(state->level_bar),
                                       GTK_LEVEL_BAR_OFFSET_FULL);
     gtk_box_pack_start(GTK_BOX(box), state->level_bar, FALSE, FALSE, 0);
+    state->capture.metered = true;  // drives level_bar while capturing
 
     // Live transcription view (hidden by default, shown during recording)
     state->live_transcription_scroll = gtk_scrolled_window_new(nullptr, nullptr);
@@ -2360,6 +7666,10 @@ static void activate(GApplication *app, gpointer user_data) {
         GTK_TEXT_VIEW(state->live_transcription_view), FALSE);
     gtk_text_view_set_wrap_mode(GTK_TEXT_VIEW(state->live_transcription_view),
                                  GTK_WRAP_WORD_CHAR);
+    GtkTextIter live_end;
+    gtk_text_buffer_get_end_iter(live_view_buffer(state), &live_end);
+    state->live_view_end = gtk_text_buffer_create_mark(
+        live_view_buffer(state), "live-end", &live_end, FALSE);
     gtk_container_add(GTK_CONTAINER(state->live_transcription_scroll),
                       state->live_transcription_view);
     gtk_widget_set_no_show_all(state->live_transcription_scroll, TRUE);
@@ -2414,6 +7724,17 @@ static void activate(GApplication *app, gpointer user_data) {
                      G_CALLBACK(on_menu_transcribe), state);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), transcribe_item);
 
+    // Bulk transcription (hidden if transcription not available)
+    state->transcribe_all_menu_item =
+        gtk_menu_item_new_with_label("Transcribe All Pending");
+    g_signal_connect(state->transcribe_all_menu_item, "activate",
+                     G_CALLBACK(on_menu_transcribe_all), state);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu),
+                          state->transcribe_all_menu_item);
+    if (!state->transcription_available) {
+        gtk_widget_set_no_show_all(state->transcribe_all_menu_item, TRUE);
+    }
+
     // Dictation menu item (hidden if transcription not available)
     state->dictation_menu_item =
         gtk_menu_item_new_with_label("Speak To Type");
@@ -2465,6 +7786,10 @@ static void activate(GApplication *app, gpointer user_data) {
                   "use tray menu for dictation");
     }
 
+    // Find the typing backend now so starting dictation never waits on it
+    typing_worker_start(state);
+    probe_typing_tools(state);
+
     // Connect to PulseAudio (once)
     if (state->pa_ctx == nullptr) {
         init_pulseaudio(state);
@@ -2494,10 +7819,8 @@ int main(int argc, char *argv[]) {
     if (!is_wayland_session() && !state.hotkey.empty()) {
         keybinder_unbind_all(state.hotkey.c_str());
     }
-    if (state.xdo != nullptr) {
-        xdo_free(state.xdo);
-        state.xdo = nullptr;
-    }
+    typing_worker_stop(&state);
+    journal_close(&state.journal);  // left for recovery if still recording
 
     cleanup_transcription_service(&state);
     cleanup_pulseaudio(&state);
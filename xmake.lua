@@ -78,6 +78,17 @@ package("keybinder-3.0")
 package_end()
 add_requires("keybinder-3.0", {system = true})
 
+package("sndfile")
+    set_homepage("https://libsndfile.github.io/libsndfile/")
+    add_extsources("pkgconfig::sndfile")
+    on_fetch(function (package, opt)
+        if opt.system then
+            return package:find_package("pkgconfig::sndfile")
+        end
+    end)
+package_end()
+add_requires("sndfile", {system = true})
+
 package("libxdo")
     set_homepage("https://github.com/jordansissel/xdotool")
     on_fetch(function (package)
@@ -90,7 +101,7 @@ add_requires("libxdo", {system = true})
 target("linscribe")
     set_kind("binary")
     add_files("src/*.cpp")
-    add_packages("gtk3", "ayatana-appindicator3", "libpulse", "libpulse-mainloop-glib", "libsoup-3.0", "json-glib", "keybinder-3.0", "libxdo")
+    add_packages("gtk3", "ayatana-appindicator3", "libpulse", "libpulse-mainloop-glib", "libsoup-3.0", "json-glib", "keybinder-3.0", "sndfile", "libxdo")
 
     -- Set optimization
     if is_mode("release") then